@@ -0,0 +1,64 @@
+//
+//  BatchBenchmark.cpp
+//  Cracked
+//
+//  Runs Decrypter::crackBatch over a file of ciphertexts (one per line) at several thread counts and reports
+//  per-message latency percentiles and aggregate throughput, for sizing the batch thread pool.
+//  Build and run from the repository root:
+//      g++ -std=gnu++17 -O2 -pthread -ICracked Benchmarks/BatchBenchmark.cpp Cracked/Decrypter.cpp Cracked/Tokenizer.cpp Cracked/Translator.cpp Cracked/WordList.cpp -o batch_bench
+//      ./batch_bench ciphertexts.txt Cracked/wordlist.txt [max threads]
+//
+
+#include "provided.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <cstdlib>
+using namespace std;
+
+double percentile(vector<double> values, double fraction)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    sort(values.begin(), values.end());
+    return values[int(fraction * (values.size() - 1))];
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " ciphertexts.txt [wordlist.txt] [max threads]" << endl;
+        return 1;
+    }
+    ifstream infile(argv[1]);
+    if (!infile) {
+        cerr << "Error! Cannot open " << argv[1] << endl;
+        return 1;
+    }
+    vector<string> ciphertexts;
+    string s;
+    while (getline(infile, s)) {
+        ciphertexts.push_back(s);
+    }
+    Decrypter d;
+    string wordlist = argc > 2 ? argv[2] : "wordlist.txt";
+    if (!d.load(wordlist)) {
+        return 1;
+    }
+    int maxThreads = argc > 3 ? atoi(argv[3]) : max(1u, thread::hardware_concurrency());
+    vector<vector<string>> serial;
+    for (int threads = 1; threads <= maxThreads; threads *= 2) {
+        d.setThreadCount(threads);
+        BatchReport report;
+        vector<vector<string>> decryptions = d.crackBatch(ciphertexts, &report);
+        if (threads == 1) {
+            serial = decryptions;
+        }
+        cout << threads << " threads: " << report.m_messagesPerSecond << " messages/s, latency p50 " << percentile(report.m_latencyMs, 0.5) << " ms, p90 " << percentile(report.m_latencyMs, 0.9) << " ms, p99 " << percentile(report.m_latencyMs, 0.99) << " ms, max " << percentile(report.m_latencyMs, 1.0) << " ms" << (decryptions == serial ? "" : "  MISMATCH") << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,275 @@
+//
+//  BenchmarkSuite.cpp
+//  Cracked
+//
+//  The regression benchmark: loads a word list, then measures lookups, Translator and cracking over a corpus
+//  generated from a seed, so two runs with the same seed and word list (and standard library) time the same work.
+//  Each message is a random sequence of word list words, with word lengths distributed as in English text,
+//  encrypted with a random key the way main.cpp's encrypt does. Cracks are reported per bucket of message length
+//  and of ambiguity, the number of decryptions found.
+//  Every result is printed as one JSON object per line, ready to be appended to a file tracking runs over time.
+//  Build and run from the repository root (Linux):
+//      g++ -std=gnu++17 -O2 -pthread -ICracked Benchmarks/BenchmarkSuite.cpp Cracked/Decrypter.cpp Cracked/Tokenizer.cpp Cracked/Translator.cpp Cracked/WordList.cpp -o benchmark_suite
+//      ./benchmark_suite Cracked/wordlist.txt [seed] [messages per length]
+//
+
+#include "provided.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <numeric>
+#include <chrono>
+#include <cstdlib>
+using namespace std;
+
+const unsigned int DEFAULT_SEED = 2018;
+const int DEFAULT_MESSAGES = 50;  //per length bucket
+const int LOADS = 3;
+const int LOOKUP_ROUNDS = 5;
+const int TRANSLATOR_CYCLES = 20000;
+const long MAX_CRACK_NODES = 20000;  //random word sequences can have millions of decryptions; stop those early
+const long MAX_CRACK_RESULTS = 1000;
+
+struct LengthBucket{
+    const char* m_name;
+    int m_words;
+};
+const LengthBucket LENGTHS[] = {{"short", 3}, {"medium", 6}, {"long", 12}};
+
+struct AmbiguityBucket{
+    const char* m_name;
+    int m_maxDecryptions;  //a message goes in the first bucket it has at most this many decryptions for
+};
+const AmbiguityBucket AMBIGUITIES[] = {{"unique", 1}, {"few", 10}, {"many", 2147483647}};  //plus "capped", for cracks stopped by a limit
+
+//How often English running text has words of each length, in percent, from 1 letter up; a uniform pick from the
+//word list would mostly give long, rare words, which leave nothing ambiguous to crack.
+const double WORD_LENGTH_PERCENT[] = {3, 17, 21, 17, 12, 9, 8, 6, 4, 2, 1};
+
+struct Message{
+    string m_plaintext;
+    string m_ciphertext;
+    vector<string> m_plainWords;
+    vector<string> m_cipherWords;
+    int m_length;  //index into LENGTHS
+};
+
+void report(const string& benchmark, const string& metric, double value, const string& unit)
+{
+    cout << "{\"benchmark\": \"" << benchmark << "\", \"metric\": \"" << metric << "\", \"value\": " << value << ", \"unit\": \"" << unit << "\"}" << endl;
+}
+
+double percentile(vector<double> values, double fraction)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    sort(values.begin(), values.end());
+    return values[int(fraction * (values.size() - 1))];
+}
+
+double msSince(chrono::steady_clock::time_point start)
+{
+    return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+string encrypt(const string& plaintext, mt19937& engine) //main.cpp's encrypt, with a seeded engine
+{
+    char plaintextAlphabet[26+1];
+    iota(plaintextAlphabet, plaintextAlphabet+26, 'a');
+    plaintextAlphabet[26] = '\0';
+    string ciphertextAlphabet(plaintextAlphabet);
+    shuffle(ciphertextAlphabet.begin(), ciphertextAlphabet.end(), engine);
+    Translator t;
+    t.pushMapping(plaintextAlphabet, ciphertextAlphabet);
+    return t.getTranslation(plaintext);
+}
+
+vector<Message> generateCorpus(const vector<string>& words, int messagesPerLength, mt19937& engine)
+{
+    const int maxLength = sizeof(WORD_LENGTH_PERCENT) / sizeof(WORD_LENGTH_PERCENT[0]);
+    vector<vector<string>> wordsOfLength(maxLength + 1);
+    for (int i = 0; i < words.size(); i++) {
+        wordsOfLength[min<int>(words[i].length(), maxLength)].push_back(words[i]);
+    }
+    vector<double> weights(1, 0);
+    for (int length = 1; length <= maxLength; length++) {
+        weights.push_back(wordsOfLength[length].empty() ? 0 : WORD_LENGTH_PERCENT[length - 1]);
+    }
+    discrete_distribution<int> pickLength(weights.begin(), weights.end());
+    vector<Message> corpus;
+    for (int l = 0; l < sizeof(LENGTHS) / sizeof(LENGTHS[0]); l++) {
+        for (int m = 0; m < messagesPerLength; m++) {
+            Message message;
+            message.m_length = l;
+            for (int w = 0; w < LENGTHS[l].m_words; w++) {
+                const vector<string>& candidates = wordsOfLength[pickLength(engine)];
+                string word = candidates[uniform_int_distribution<int>(0, candidates.size() - 1)(engine)];
+                message.m_plainWords.push_back(word);
+                message.m_plaintext += (w == 0 ? "" : " ") + word;
+            }
+            message.m_plaintext += ".";
+            message.m_ciphertext = encrypt(message.m_plaintext, engine);
+            int start = 0;
+            for (int w = 0; w < message.m_plainWords.size(); w++) { //the translation keeps every character's position
+                message.m_cipherWords.push_back(message.m_ciphertext.substr(start, message.m_plainWords[w].length()));
+                start += message.m_plainWords[w].length() + 1;
+            }
+            corpus.push_back(message);
+        }
+    }
+    return corpus;
+}
+
+int main(int argc, char* argv[])
+{
+    string filename = argc > 1 ? argv[1] : "wordlist.txt";
+    unsigned int seed = argc > 2 ? strtoul(argv[2], nullptr, 10) : DEFAULT_SEED;
+    int messagesPerLength = argc > 3 ? atoi(argv[3]) : DEFAULT_MESSAGES;
+    ifstream infile(filename);
+    if (!infile) {
+        cerr << "Error! Cannot open " << filename << endl;
+        return 1;
+    }
+    vector<string> words;
+    string s;
+    while (getline(infile, s)) {
+        string word = s.substr(0, s.find_first_of(" \t"));
+        if (!word.empty() && all_of(word.begin(), word.end(), [](char ch) { return isalpha(ch) || ch == '\''; })) {
+            words.push_back(word);
+        }
+    }
+    if (words.empty()) {
+        cerr << "Error! No words in " << filename << endl;
+        return 1;
+    }
+    mt19937 engine(seed);
+    vector<Message> corpus = generateCorpus(words, messagesPerLength, engine);
+    report("corpus", "seed", seed, "");
+    report("corpus", "messages", corpus.size(), "messages");
+
+    double bestLoadMs = 0;
+    for (int i = 0; i < LOADS; i++) {
+        WordList wl;
+        auto start = chrono::steady_clock::now();
+        if (!wl.loadWordList(filename)) {
+            return 1;
+        }
+        double ms = msSince(start);
+        bestLoadMs = (i == 0 || ms < bestLoadMs) ? ms : bestLoadMs;
+    }
+    report("loadWordList", "best_of_" + to_string(LOADS), bestLoadMs, "ms");
+
+    WordList wl;
+    wl.loadWordList(filename);
+    vector<string> hits;
+    vector<string> misses;
+    vector<string> cipherWords;
+    vector<string> partials;  //each cipher word's plaintext with every other letter still unknown
+    for (int i = 0; i < corpus.size(); i++) {
+        for (int w = 0; w < corpus[i].m_plainWords.size(); w++) {
+            string partial = corpus[i].m_plainWords[w];
+            for (int j = 1; j < partial.length(); j += 2) {
+                if (partial[j] != '\'') {
+                    partial[j] = '?';
+                }
+            }
+            hits.push_back(corpus[i].m_plainWords[w]);
+            misses.push_back(corpus[i].m_plainWords[w] + "q");
+            cipherWords.push_back(corpus[i].m_cipherWords[w]);
+            partials.push_back(partial);
+        }
+    }
+    long checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for (int round = 0; round < LOOKUP_ROUNDS; round++) {
+        for (int i = 0; i < hits.size(); i++) {
+            checksum += wl.contains(hits[i]) + wl.contains(misses[i]);
+        }
+    }
+    report("contains", "latency", msSince(start) * 1e6 / (2.0 * LOOKUP_ROUNDS * hits.size()), "ns/op");
+    start = chrono::steady_clock::now();
+    for (int round = 0; round < LOOKUP_ROUNDS; round++) {
+        for (int i = 0; i < cipherWords.size(); i++) {
+            checksum += wl.findCandidates(cipherWords[i], partials[i]).size();
+        }
+    }
+    report("findCandidates", "latency", msSince(start) * 1e6 / (LOOKUP_ROUNDS * cipherWords.size()), "ns/op");
+
+    Translator t;
+    double pushMs = 0;
+    double popMs = 0;
+    long operations = 0;
+    for (int cycle = 0; cycle < TRANSLATOR_CYCLES; cycle++) { //push a message's words one by one, then unwind
+        const Message& message = corpus[cycle % corpus.size()];
+        start = chrono::steady_clock::now();
+        for (int w = 0; w < message.m_cipherWords.size(); w++) {
+            checksum += t.pushMapping(message.m_cipherWords[w], message.m_plainWords[w]);
+        }
+        auto pushed = chrono::steady_clock::now();
+        for (int w = 0; w < message.m_cipherWords.size(); w++) {
+            checksum += t.popMapping();
+        }
+        pushMs += chrono::duration<double, milli>(pushed - start).count();
+        popMs += msSince(pushed);
+        operations += message.m_cipherWords.size();
+    }
+    report("Translator", "pushMapping", pushMs * 1e6 / operations, "ns/op");
+    report("Translator", "popMapping", popMs * 1e6 / operations, "ns/op");
+
+    Decrypter d;
+    if (!d.load(filename)) {
+        return 1;
+    }
+    const int lengthCount = sizeof(LENGTHS) / sizeof(LENGTHS[0]);
+    const int ambiguityCount = sizeof(AMBIGUITIES) / sizeof(AMBIGUITIES[0]);
+    vector<double> latencyMs[lengthCount][ambiguityCount + 1];
+    long nodes[lengthCount][ambiguityCount + 1] = {};
+    CrackLimits limits;
+    limits.m_maxNodes = MAX_CRACK_NODES;
+    limits.m_maxResults = MAX_CRACK_RESULTS;
+    vector<double> allLatencyMs;
+    long allNodes = 0;
+    double allMs = 0;
+    for (int i = 0; i < corpus.size(); i++) {
+        CrackStats stats;
+        bool complete;
+        vector<string> decryptions = d.crack(corpus[i].m_ciphertext, limits, &complete, &stats);
+        int a = 0;
+        while (a < ambiguityCount && (!complete || decryptions.size() > AMBIGUITIES[a].m_maxDecryptions)) {
+            a++;
+        }
+        latencyMs[corpus[i].m_length][a].push_back(stats.m_wallMs);
+        nodes[corpus[i].m_length][a] += stats.m_nodesExpanded;
+        allLatencyMs.push_back(stats.m_wallMs);
+        allNodes += stats.m_nodesExpanded;
+        allMs += stats.m_wallMs;
+        checksum += decryptions.size();
+    }
+    for (int l = 0; l < lengthCount; l++) {
+        for (int a = 0; a <= ambiguityCount; a++) {
+            const vector<double>& latencies = latencyMs[l][a];
+            if (latencies.empty()) {
+                continue;
+            }
+            string bucket = string("crack/") + LENGTHS[l].m_name + "/" + (a < ambiguityCount ? AMBIGUITIES[a].m_name : "capped");
+            double ms = accumulate(latencies.begin(), latencies.end(), 0.0);
+            report(bucket, "messages", latencies.size(), "messages");
+            report(bucket, "p50", percentile(latencies, 0.5), "ms");
+            report(bucket, "p90", percentile(latencies, 0.9), "ms");
+            report(bucket, "p99", percentile(latencies, 0.99), "ms");
+            report(bucket, "max", percentile(latencies, 1.0), "ms");
+            report(bucket, "throughput", ms > 0 ? nodes[l][a] / (ms / 1000) : 0, "nodes/s");
+        }
+    }
+    report("crack", "p50", percentile(allLatencyMs, 0.5), "ms");
+    report("crack", "p90", percentile(allLatencyMs, 0.9), "ms");
+    report("crack", "p99", percentile(allLatencyMs, 0.99), "ms");
+    report("crack", "max", percentile(allLatencyMs, 1.0), "ms");
+    report("crack", "throughput", allMs > 0 ? allNodes / (allMs / 1000) : 0, "nodes/s");
+    report("checksum", "value", checksum, "");
+    return 0;
+}
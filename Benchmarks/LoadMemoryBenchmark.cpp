@@ -0,0 +1,191 @@
+//
+//  LoadMemoryBenchmark.cpp
+//  Cracked
+//
+//  Loads a word list from its text file, as a long-running process reloading its dictionary would, and reports
+//  the heap allocations each load makes, the bytes they ask for, and the peak resident set size. Linux only.
+//  Three runs, each in a child process of its own so its peak RSS is its own:
+//    loadWordList    the real loader, which keeps its words and hash tables in an arena
+//    heap tables     the loader's grouping pass (every word kept, counted and grouped by pattern key) with heap
+//                    strings and MyHash's HeapAllocator, emptied with reset between loads
+//    arena tables    the same pass with the words copied into an Arena and ArenaAllocator tables, emptied with
+//                    reset and the arena rewound between loads
+//  Build and run from the repository root:
+//      g++ -std=gnu++17 -O2 -ICracked Benchmarks/LoadMemoryBenchmark.cpp Cracked/WordList.cpp -o load_memory_bench
+//      ./load_memory_bench Cracked/wordlist.txt [loads]
+//
+
+#include "provided.h"
+#include "MyHash.h"
+#include "Arena.h"
+#include "Pattern.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+using namespace std;
+
+long g_allocations = 0;  //every operator new in the process goes through the replacements below
+long g_allocatedBytes = 0;
+
+void* operator new(size_t size)
+{
+    g_allocations++;
+    g_allocatedBytes += size;
+    void* p = malloc(size == 0 ? 1 : size);
+    if (p == nullptr) {
+        throw bad_alloc();
+    }
+    return p;
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+unsigned int hash(const PatternKey& key);  //defined in WordList.cpp, like the string hashes MyHash uses below
+
+long peakRssKb()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;  //kilobytes on Linux
+}
+
+//the grouping pass of loadWordList with heap strings and heap tables
+class HeapTables
+{
+public:
+    void load(const vector<string>& lines)
+    {
+        m_words.reset();
+        m_groups.reset();
+        m_loaded.clear();
+        for (const string& line : lines) {
+            string word = line;
+            double* count = m_words.find(word);
+            if (count == nullptr) {
+                m_words.associate(word, 1);
+            }
+            else {
+                *count += 1;
+            }
+            PatternKey key = patternKey(word);
+            int* group = m_groups.find(key);
+            if (group == nullptr) {
+                m_groups.associate(key, m_groups.getNumItems());
+            }
+            m_loaded.push_back(word);
+        }
+    }
+private:
+    MyHash<string, double> m_words;
+    MyHash<PatternKey, int> m_groups;
+    vector<string> m_loaded;
+};
+
+//the same pass with the words and tables in an arena
+class ArenaTables
+{
+public:
+    ArenaTables(): m_words(0.5, ArenaAllocator(m_arena)), m_groups(0.5, ArenaAllocator(m_arena)) {}
+    void load(const vector<string>& lines)
+    {
+        m_arena.reset();  //first, so the tables' new ones come from the rewound arena; their old slots need no destroying
+        m_words.reset();
+        m_groups.reset();
+        m_loaded.clear();
+        for (const string& line : lines) {
+            string_view word = m_arena.copy(line);
+            double* count = m_words.find(word);
+            if (count == nullptr) {
+                m_words.associate(word, 1);
+            }
+            else {
+                *count += 1;
+            }
+            PatternKey key = patternKey(word);
+            int* group = m_groups.find(key);
+            if (group == nullptr) {
+                m_groups.associate(key, m_groups.getNumItems());
+            }
+            m_loaded.push_back(word);
+        }
+    }
+private:
+    Arena m_arena;  //declared first, so it outlives the tables in it
+    MyHash<string_view, double, ArenaAllocator> m_words;
+    MyHash<PatternKey, int, ArenaAllocator> m_groups;
+    vector<string_view> m_loaded;
+};
+
+template <typename Load>
+void measure(const string& name, int loads, Load load)  //runs load loads times in a child process and reports each
+{
+    cout.flush();
+    pid_t child = fork();
+    if (child < 0) {
+        cerr << "Error! Cannot fork" << endl;
+        return;
+    }
+    if (child > 0) {
+        int status;
+        waitpid(child, &status, 0);
+        return;
+    }
+    for (int i = 0; i < loads; i++) {
+        long allocations = g_allocations;
+        long bytes = g_allocatedBytes;
+        auto start = chrono::steady_clock::now();
+        if (!load()) {
+            _exit(1);
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        cout << name << " load " << i + 1 << ": " << g_allocations - allocations << " allocations, " << (g_allocatedBytes - bytes) / 1024 << " KB requested, " << ms << " ms, peak RSS " << peakRssKb() << " KB" << endl;
+    }
+    _exit(0);
+}
+
+int main(int argc, char* argv[])
+{
+    string filename = argc > 1 ? argv[1] : "wordlist.txt";
+    int loads = argc > 2 ? atoi(argv[2]) : 5;
+    measure("loadWordList", loads, [&] {
+        static WordList wl;
+        return wl.loadWordList(filename);
+    });
+    ifstream infile(filename);
+    if (!infile) {
+        cerr << "Error! Cannot open " << filename << endl;
+        return 1;
+    }
+    vector<string> lines;
+    string s;
+    while (getline(infile, s)) {
+        lines.push_back(s);
+    }
+    measure("heap tables ", loads, [&] {
+        static HeapTables tables;
+        tables.load(lines);
+        return true;
+    });
+    measure("arena tables", loads, [&] {
+        static ArenaTables tables;
+        tables.load(lines);
+        return true;
+    });
+    return 0;
+}
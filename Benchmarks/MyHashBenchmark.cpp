@@ -0,0 +1,177 @@
+//
+//  MyHashBenchmark.cpp
+//  Cracked
+//
+//  Compares insert and lookup throughput of MyHash against the chained linked-list table it replaced.
+//  Build and run from the repository root:
+//      g++ -std=gnu++17 -O2 -ICracked Benchmarks/MyHashBenchmark.cpp Cracked/WordList.cpp -o myhash_bench
+//      ./myhash_bench Cracked/wordlist.txt
+//
+
+#include "MyHash.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+using namespace std;
+
+unsigned int hash(const std::string& s); //defined in WordList.cpp
+
+const int CHAINED_HASH_TABLE_SIZE = 100;  //the previous DEFAULT_HASH_TABLE_SIZE
+
+//The previous MyHash engine, kept as it was (including reHash copying every node and leaking the old ones) so the two can be compared on the same workload.
+template<typename KeyType, typename ValueType>
+class ChainedHash
+{
+public:
+    ChainedHash(double maxLoadFactor = 0.5) : m_maxLoadFactor(maxLoadFactor), m_currentLoadFactor(0), m_buckets(CHAINED_HASH_TABLE_SIZE), m_items(0)
+    {
+        m_hashTable = new Node* [m_buckets];
+        for (int i = 0; i < m_buckets; i++) {
+            m_hashTable[i] = nullptr;
+        }
+    }
+    ~ChainedHash()
+    {
+        for (int i = 0; i < m_buckets; i++) {
+            Node* begin = m_hashTable[i];
+            while (begin != nullptr) {
+                Node* killMe = begin;
+                begin = begin->m_next;
+                delete killMe;
+            }
+        }
+        delete [] m_hashTable;
+    }
+    void associate(const KeyType& key, const ValueType& value)
+    {
+        unsigned int hash_key = ::hash(key) % m_buckets;
+        Node* p = m_hashTable[hash_key];
+        if (find(key) != nullptr) {
+            while (p != nullptr && p->m_key != key) {
+                p = p->m_next;
+            }
+            p->m_value = value;
+        }
+        else {
+            m_items++;
+            m_currentLoadFactor = double(m_items)/double(m_buckets);
+            Node* newNode = new Node();
+            newNode->m_key = key;
+            newNode->m_value = value;
+            newNode->m_next = nullptr;
+            if (p == nullptr) {
+                m_hashTable[hash_key] = newNode;
+            }
+            else{
+                while (p->m_next != nullptr) {
+                    p = p->m_next;
+                }
+                p->m_next = newNode;
+            }
+            if (m_currentLoadFactor > m_maxLoadFactor) {
+                reHash();
+            }
+        }
+    }
+    const ValueType* find(const KeyType& key) const
+    {
+        Node* temp = m_hashTable[::hash(key) % m_buckets];
+        while (temp != nullptr) {
+            if (temp->m_key == key) {
+                return &(temp->m_value);
+            }
+            temp = temp->m_next;
+        }
+        return nullptr;
+    }
+private:
+    struct Node{
+        KeyType m_key;
+        ValueType m_value;
+        Node* m_next;
+    };
+    double m_maxLoadFactor;
+    double m_currentLoadFactor;
+    Node** m_hashTable;
+    int m_buckets;
+    int m_items;
+    void reHash()
+    {
+        int previousSize = m_buckets;
+        m_buckets *= 2;
+        Node** newHashTable = new Node* [m_buckets];
+        for (int i = 0; i < m_buckets; i++) {
+            newHashTable[i] = nullptr;
+        }
+        for (int i = 0; i < previousSize; i++) {
+            Node* p = m_hashTable[i];
+            while (p != nullptr) {
+                unsigned int newSlot = ::hash(p->m_key) % m_buckets;
+                Node* newNode = new Node();
+                newNode->m_key = p->m_key;
+                newNode->m_value = p->m_value;
+                newNode->m_next = nullptr;
+                if (newHashTable[newSlot] == nullptr) {
+                    newHashTable[newSlot] = newNode;
+                }
+                else{
+                    Node* q = newHashTable[newSlot];
+                    while (q->m_next != nullptr) {
+                        q = q->m_next;
+                    }
+                    q->m_next = newNode;
+                }
+                p = p->m_next;
+            }
+        }
+        m_currentLoadFactor /= 2.0;
+        m_hashTable = newHashTable;
+    }
+};
+
+template <class Table>
+void runBenchmark(const string& name, const vector<string>& keys, const vector<string>& misses)
+{
+    const int LOOKUP_ROUNDS = 10;
+    auto start = chrono::steady_clock::now();
+    Table* table = new Table;
+    for (int i = 0; i < keys.size(); i++) {
+        table->associate(keys[i], i);
+    }
+    auto inserted = chrono::steady_clock::now();
+    long found = 0;
+    for (int round = 0; round < LOOKUP_ROUNDS; round++) {
+        for (int i = 0; i < keys.size(); i++) {
+            found += (table->find(keys[i]) != nullptr);
+            found += (table->find(misses[i]) != nullptr);
+        }
+    }
+    auto looked = chrono::steady_clock::now();
+    delete table;
+    double insertNs = chrono::duration<double, nano>(inserted - start).count() / keys.size();
+    double lookupNs = chrono::duration<double, nano>(looked - inserted).count() / (2.0 * LOOKUP_ROUNDS * keys.size());
+    cout << name << ": insert " << insertNs << " ns/op (" << 1e3 / insertNs << " Mops/s), lookup " << lookupNs << " ns/op (" << 1e3 / lookupNs << " Mops/s), hits " << found / LOOKUP_ROUNDS << endl;
+}
+
+int main(int argc, char* argv[])
+{
+    string filename = argc > 1 ? argv[1] : "wordlist.txt";
+    ifstream infile(filename);
+    if (!infile) {
+        cerr << "Error! Cannot open " << filename << endl;
+        return 1;
+    }
+    vector<string> keys;
+    vector<string> misses;
+    string s;
+    while (getline(infile, s)) {
+        keys.push_back(s);
+        misses.push_back(s + "#"); //never a dictionary word, so every probe of these is a miss
+    }
+    cout << keys.size() << " keys from " << filename << endl;
+    runBenchmark<ChainedHash<string, int>>("chained MyHash    ", keys, misses);
+    runBenchmark<MyHash<string, int>>("robin hood MyHash ", keys, misses);
+    return 0;
+}
@@ -0,0 +1,92 @@
+//
+//  PatternBenchmark.cpp
+//  Cracked
+//
+//  Compares building each word list word's letter pattern as a string, the way patterns were keyed before, with
+//  packing it into a PatternKey, and times loading the word list end to end.
+//  Build and run from the repository root:
+//      g++ -std=gnu++17 -O2 -ICracked Benchmarks/PatternBenchmark.cpp Cracked/WordList.cpp -o pattern_bench
+//      ./pattern_bench Cracked/wordlist.txt
+//
+
+#include "provided.h"
+#include "Pattern.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cctype>
+using namespace std;
+
+const int ROUNDS = 10;
+const int LOADS = 5;
+
+string stringPattern(const string& s) //a pattern string built one character at a time
+{
+    char generator[26] = {};
+    char c = 'A';
+    string pattern;
+    for (int i = 0; i < s.length(); i++) {
+        if (isalpha(s[i])) {
+            char& ch = generator[toupper(s[i]) - 'A'];
+            if (ch == 0) {
+                ch = c++;
+            }
+            pattern += ch;
+        }
+        else if (s[i] == '\'') {
+            pattern += s[i];
+        }
+    }
+    return pattern;
+}
+
+unsigned int hash(const std::string& s); //defined in WordList.cpp, as MyHash hashed the pattern strings
+
+int main(int argc, char* argv[])
+{
+    string filename = argc > 1 ? argv[1] : "wordlist.txt";
+    ifstream infile(filename);
+    if (!infile) {
+        cerr << "Error! Cannot open " << filename << endl;
+        return 1;
+    }
+    vector<string> words;
+    string s;
+    while (getline(infile, s)) {
+        words.push_back(s.substr(0, s.find_first_of(" \t")));
+    }
+    long checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < words.size(); i++) {
+            checksum += ::hash(stringPattern(words[i]));
+        }
+    }
+    auto strings = chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < words.size(); i++) {
+            checksum += patternKeyHash(patternKey(words[i]));
+        }
+    }
+    auto keys = chrono::steady_clock::now();
+    double patterns = double(ROUNDS) * words.size();
+    cout << "string pattern + hash: " << chrono::duration<double, nano>(strings - start).count() / patterns << " ns/word" << endl;
+    cout << "PatternKey + hash: " << chrono::duration<double, nano>(keys - strings).count() / patterns << " ns/word" << endl;
+    double bestLoadMs = 0;
+    for (int i = 0; i < LOADS; i++) {
+        WordList wl;
+        auto loadStart = chrono::steady_clock::now();
+        if (!wl.loadWordList(filename)) {
+            return 1;
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - loadStart).count();
+        if (i == 0 || ms < bestLoadMs) {
+            bestLoadMs = ms;
+        }
+    }
+    cout << "load " << bestLoadMs << " ms (best of " << LOADS << ")" << endl;
+    cout << "checksum " << checksum << endl;
+    return 0;
+}
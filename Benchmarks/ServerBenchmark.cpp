@@ -0,0 +1,118 @@
+//
+//  ServerBenchmark.cpp
+//  Cracked
+//
+//  Load generator for the decrypter server (main.cpp's --serve mode). Opens 1, 2, 4, ... up to the given number
+//  of connections at once, each sending its share of the requests back to back, cycling through a file of
+//  ciphertexts (one per line), and reports throughput and latency percentiles at each concurrency. Latency is
+//  measured by the client, from sending a request to having read its whole response.
+//  Every result is printed as one JSON object per line, like BenchmarkSuite's.
+//  Build and run from the repository root (Linux), with the server already running:
+//      g++ -std=gnu++17 -O2 -pthread -ICracked Benchmarks/ServerBenchmark.cpp -o server_bench
+//      ./server_bench decrypter.sock ciphertexts.txt [max connections] [requests per concurrency] [deadline ms]
+//
+
+#include "Protocol.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdlib>
+using namespace std;
+
+const int DEFAULT_MAX_CONNECTIONS = 16;
+const int DEFAULT_REQUESTS = 2000;  //per concurrency, split between the connections
+
+void report(const string& benchmark, const string& metric, double value, const string& unit)
+{
+    cout << "{\"benchmark\": \"" << benchmark << "\", \"metric\": \"" << metric << "\", \"value\": " << value << ", \"unit\": \"" << unit << "\"}" << endl;
+}
+
+double percentile(vector<double> values, double fraction)
+{
+    if (values.empty()) {
+        return 0;
+    }
+    sort(values.begin(), values.end());
+    return values[int(fraction * (values.size() - 1))];
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        cerr << "Usage: " << argv[0] << " socket ciphertexts.txt [max connections] [requests per concurrency] [deadline ms]" << endl;
+        return 1;
+    }
+    ifstream infile(argv[2]);
+    if (!infile) {
+        cerr << "Error! Cannot open " << argv[2] << endl;
+        return 1;
+    }
+    vector<string> ciphertexts;
+    string s;
+    while (getline(infile, s)) {
+        ciphertexts.push_back(s);
+    }
+    if (ciphertexts.empty()) {
+        cerr << "Error! " << argv[2] << " has no ciphertexts" << endl;
+        return 1;
+    }
+    int maxConnections = argc > 3 ? max(1, atoi(argv[3])) : DEFAULT_MAX_CONNECTIONS;
+    int requests = argc > 4 ? max(1, atoi(argv[4])) : DEFAULT_REQUESTS;
+    uint32_t deadlineMs = argc > 5 ? max(0, atoi(argv[5])) : 0;
+    for (int connections = 1; connections <= maxConnections; connections *= 2) {
+        vector<vector<double>> latencies(connections);
+        atomic<int> stopped(0);
+        atomic<int> failed(0);
+        vector<thread> clients;
+        auto start = chrono::steady_clock::now();
+        for (int c = 0; c < connections; c++) {
+            clients.push_back(thread([&, c] {
+                int fd = connectUnix(argv[1]);
+                if (fd < 0) {
+                    failed++;
+                    return;
+                }
+                CrackRequest request;
+                request.m_deadlineMs = deadlineMs;
+                string payload;
+                CrackResponse response;
+                for (int r = c; r < requests; r += connections) { //request r goes to connection r % connections
+                    request.m_ciphertext = ciphertexts[r % ciphertexts.size()];
+                    auto sent = chrono::steady_clock::now();
+                    if (!writeFrame(fd, encodeRequest(request)) || !readFrame(fd, payload) || !decodeResponse(payload, response) || response.m_status == RESPONSE_BAD_REQUEST) {
+                        failed++;
+                        break;
+                    }
+                    latencies[c].push_back(chrono::duration<double, milli>(chrono::steady_clock::now() - sent).count());
+                    if (response.m_status == RESPONSE_STOPPED) {
+                        stopped++;
+                    }
+                }
+                close(fd);
+            }));
+        }
+        for (int c = 0; c < clients.size(); c++) {
+            clients[c].join();
+        }
+        double totalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        vector<double> all;
+        for (int c = 0; c < connections; c++) {
+            all.insert(all.end(), latencies[c].begin(), latencies[c].end());
+        }
+        string benchmark = "server_c" + to_string(connections);
+        report(benchmark, "requests_per_second", totalMs > 0 ? all.size() * 1000.0 / totalMs : 0, "1/s");
+        report(benchmark, "p50", percentile(all, 0.5), "ms");
+        report(benchmark, "p90", percentile(all, 0.9), "ms");
+        report(benchmark, "p99", percentile(all, 0.99), "ms");
+        report(benchmark, "p999", percentile(all, 0.999), "ms");
+        report(benchmark, "max", percentile(all, 1.0), "ms");
+        report(benchmark, "stopped_at_deadline", stopped, "requests");
+        report(benchmark, "failed", failed, "connections");
+    }
+    return 0;
+}
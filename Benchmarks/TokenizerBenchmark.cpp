@@ -0,0 +1,43 @@
+//
+//  TokenizerBenchmark.cpp
+//  Cracked
+//
+//  Measures Tokenizer on a ciphertext-sized message, returning a vector of strings against filling a reused
+//  vector of string_views.
+//  Build and run from the repository root:
+//      g++ -std=gnu++17 -O2 -ICracked Benchmarks/TokenizerBenchmark.cpp Cracked/Tokenizer.cpp -o tokenizer_bench
+//      ./tokenizer_bench
+//
+
+#include "provided.h"
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <chrono>
+using namespace std;
+
+const string MESSAGE = "Xjop ct yrg zxtt, qwn'y gvrqj vwj jqxyz (ds \"fs\") 1024; Vxppd, jxu wjj!";
+const int CALLS = 500000;
+
+int main()
+{
+    Tokenizer t(" 0123456789,;:.!()[]{}-\"#$%^&");
+    long checksum = 0;
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < CALLS; i++) {
+        vector<string> tokens = t.tokenize(MESSAGE);
+        checksum += tokens.size() + tokens.back().length();
+    }
+    auto strings = chrono::steady_clock::now();
+    vector<string_view> views;
+    for (int i = 0; i < CALLS; i++) {
+        t.tokenize(MESSAGE, views);
+        checksum += views.size() + views.back().length();
+    }
+    auto done = chrono::steady_clock::now();
+    cout << "vector<string>: " << chrono::duration<double, nano>(strings - start).count() / CALLS << " ns/message" << endl;
+    cout << "reused vector<string_view>: " << chrono::duration<double, nano>(done - strings).count() / CALLS << " ns/message" << endl;
+    cout << "checksum " << checksum << endl;
+    return 0;
+}
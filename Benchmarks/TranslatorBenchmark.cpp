@@ -0,0 +1,70 @@
+//
+//  TranslatorBenchmark.cpp
+//  Cracked
+//
+//  Measures Translator push/pop/getTranslation cycles at the search depths the decrypter reaches.
+//  Build and run from the repository root:
+//      g++ -std=gnu++17 -O2 -ICracked Benchmarks/TranslatorBenchmark.cpp Cracked/Translator.cpp -o translator_bench
+//      ./translator_bench
+//
+
+#include "provided.h"
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+using namespace std;
+
+const string PLAINTEXT = "we found the treasure under the old oak tree near the quiet river bank";
+const string KEY = "QWERTYUIOPASDFGHJKLZXCVBNM"; //ciphertext letter for each plaintext letter
+const int CYCLES = 200000;
+
+int main()
+{
+    vector<string> plainWords;
+    vector<string> cipherWords;
+    string ciphertext;
+    string word;
+    for (int i = 0; i <= PLAINTEXT.length(); i++) { //split the plaintext and encrypt it with KEY
+        if (i == PLAINTEXT.length() || PLAINTEXT[i] == ' ') {
+            string cipherWord;
+            for (int j = 0; j < word.length(); j++) {
+                cipherWord += KEY[toupper(word[j]) - 'A'];
+            }
+            plainWords.push_back(word);
+            cipherWords.push_back(cipherWord);
+            ciphertext += (ciphertext.empty() ? "" : " ") + cipherWord;
+            word = "";
+        }
+        else {
+            word += PLAINTEXT[i];
+        }
+    }
+    Translator t;
+    long checksum = 0;
+    for (int depth = 1; depth <= 10; depth++) { //one cycle pushes depth words, translates the message, then unwinds
+        double pushNs = 0;
+        double translateNs = 0;
+        double popNs = 0;
+        for (int cycle = 0; cycle < CYCLES / depth; cycle++) {
+            auto start = chrono::steady_clock::now();
+            for (int d = 0; d < depth; d++) {
+                checksum += t.pushMapping(cipherWords[d], plainWords[d]);
+            }
+            auto pushed = chrono::steady_clock::now();
+            checksum += t.getTranslation(ciphertext)[0];
+            auto translated = chrono::steady_clock::now();
+            for (int d = 0; d < depth; d++) {
+                checksum += t.popMapping();
+            }
+            auto popped = chrono::steady_clock::now();
+            pushNs += chrono::duration<double, nano>(pushed - start).count();
+            translateNs += chrono::duration<double, nano>(translated - pushed).count();
+            popNs += chrono::duration<double, nano>(popped - translated).count();
+        }
+        int cycles = CYCLES / depth;
+        cout << "depth " << depth << ": push " << pushNs / (cycles * depth) << " ns/op, pop " << popNs / (cycles * depth) << " ns/op, getTranslation " << translateNs / cycles << " ns/op" << endl;
+    }
+    cout << "checksum " << checksum << endl;
+    return 0;
+}
@@ -0,0 +1,78 @@
+//
+//  WordListBenchmark.cpp
+//  Cracked
+//
+//  Measures loading a word list from its text file and the per-query cost of contains, countCandidates and
+//  findCandidates over the list's own words, the paths that normalize and validate every word they see.
+//  Build and run from the repository root:
+//      g++ -std=gnu++17 -O2 -ICracked Benchmarks/WordListBenchmark.cpp Cracked/WordList.cpp -o wordlist_bench
+//      ./wordlist_bench Cracked/wordlist.txt
+//
+
+#include "provided.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <chrono>
+using namespace std;
+
+const int LOADS = 5;
+const int QUERY_WORDS = 20000;
+
+template <typename Query>
+double nsPerQuery(int queries, Query query) //query(i) for every i below queries
+{
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < queries; i++) {
+        query(i);
+    }
+    return chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / queries;
+}
+
+int main(int argc, char* argv[])
+{
+    string filename = argc > 1 ? argv[1] : "wordlist.txt";
+    ifstream infile(filename);
+    if (!infile) {
+        cerr << "Error! Cannot open " << filename << endl;
+        return 1;
+    }
+    vector<string> words;
+    string s;
+    while (getline(infile, s) && words.size() < QUERY_WORDS) {
+        words.push_back(s.substr(0, s.find_first_of(" \t")));
+    }
+    double bestLoadMs = 0;
+    WordList wl;
+    for (int i = 0; i < LOADS; i++) { //best of several, so a cold page cache doesn't count
+        auto start = chrono::steady_clock::now();
+        if (!wl.loadWordList(filename)) {
+            return 1;
+        }
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        if (i == 0 || ms < bestLoadMs) {
+            bestLoadMs = ms;
+        }
+    }
+    vector<string> unknowns; //each word with its letters untranslated, as the decrypter first asks about it
+    for (int i = 0; i < words.size(); i++) {
+        string t = words[i];
+        for (int j = 0; j < t.length(); j++) {
+            if (t[j] != '\'') {
+                t[j] = '?';
+            }
+        }
+        unknowns.push_back(t);
+    }
+    long checksum = 0;
+    double containsNs = nsPerQuery(words.size(), [&](int i) { checksum += wl.contains(words[i]); });
+    double countNs = nsPerQuery(words.size(), [&](int i) { checksum += wl.countCandidates(words[i], unknowns[i]); });
+    double findNs = nsPerQuery(words.size(), [&](int i) { checksum += wl.findCandidates(words[i], words[i]).size(); });
+    cout << "load " << bestLoadMs << " ms" << endl;
+    cout << "contains " << containsNs << " ns/query" << endl;
+    cout << "countCandidates, untranslated " << countNs << " ns/query" << endl;
+    cout << "findCandidates, translated " << findNs << " ns/query" << endl;
+    cout << "checksum " << checksum << endl;
+    return 0;
+}
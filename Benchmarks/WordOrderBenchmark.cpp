@@ -0,0 +1,64 @@
+//
+//  WordOrderBenchmark.cpp
+//  Cracked
+//
+//  Cracks a file of ciphertexts (one per line) with each WordOrder and reports the search nodes expanded and the
+//  wall time per message and in total, checking that both orders find the same decryptions.
+//  Build and run from the repository root:
+//      g++ -std=gnu++17 -O2 -pthread -ICracked Benchmarks/WordOrderBenchmark.cpp Cracked/Decrypter.cpp Cracked/Tokenizer.cpp Cracked/Translator.cpp Cracked/WordList.cpp -o word_order_bench
+//      ./word_order_bench ciphertexts.txt Cracked/wordlist.txt
+//
+
+#include "provided.h"
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+const WordOrder ORDERS[] = {MOST_UNTRANSLATED, FEWEST_CANDIDATES};
+const char* const ORDER_NAMES[] = {"most untranslated", "fewest candidates"};
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2) {
+        cerr << "Usage: " << argv[0] << " ciphertexts.txt [wordlist.txt]" << endl;
+        return 1;
+    }
+    ifstream infile(argv[1]);
+    if (!infile) {
+        cerr << "Error! Cannot open " << argv[1] << endl;
+        return 1;
+    }
+    vector<string> ciphertexts;
+    string s;
+    while (getline(infile, s)) {
+        ciphertexts.push_back(s);
+    }
+    Decrypter d;
+    string wordlist = argc > 2 ? argv[2] : "wordlist.txt";
+    if (!d.load(wordlist)) {
+        return 1;
+    }
+    long totalNodes[2] = {0, 0};
+    double totalMs[2] = {0, 0};
+    for (int i = 0; i < ciphertexts.size(); i++) {
+        vector<string> decryptions[2];
+        cout << ciphertexts[i] << endl;
+        for (int o = 0; o < 2; o++) {
+            CrackStats stats;
+            d.setWordOrder(ORDERS[o]);
+            decryptions[o] = d.crack(ciphertexts[i], &stats);
+            totalNodes[o] += stats.m_nodesExpanded;
+            totalMs[o] += stats.m_wallMs;
+            cout << "    " << ORDER_NAMES[o] << ": " << decryptions[o].size() << " decryptions, " << stats.m_nodesExpanded << " nodes, " << stats.m_wallMs << " ms" << endl;
+        }
+        if (decryptions[0] != decryptions[1]) {
+            cout << "    MISMATCH" << endl;
+        }
+    }
+    for (int o = 0; o < 2; o++) {
+        cout << "total " << ORDER_NAMES[o] << ": " << totalNodes[o] << " nodes, " << totalMs[o] << " ms" << endl;
+    }
+    return 0;
+}
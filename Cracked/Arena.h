@@ -0,0 +1,105 @@
+//
+//  Arena.h
+//  Cracked
+//
+
+#ifndef Arena_h
+#define Arena_h
+
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <string_view>
+#include <vector>
+
+const size_t ARENA_SLAB_SIZE = 1 << 20;
+
+//A bump allocator: hands out memory from large slabs, one after another, and never frees anything on its own.
+//reset rewinds to the first slab in O(1), keeping the slabs for the next round, so filling the arena again the
+//same way allocates nothing; the slabs themselves are freed when the arena is destroyed.
+class Arena
+{
+public:
+    Arena(size_t slabSize = ARENA_SLAB_SIZE): m_slabSize(slabSize), m_current(0), m_used(0) {}
+    ~Arena()
+    {
+        for (int i = 0; i < m_slabs.size(); i++) {
+            ::operator delete(m_slabs[i].m_memory);
+        }
+    }
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t))  //alignment is a power of 2, at most alignof(max_align_t)
+    {
+        for (;;) {
+            if (m_current == m_slabs.size()) { //out of slabs: a big request gets a slab of its own size
+                size_t size = bytes > m_slabSize ? bytes : m_slabSize;
+                char* memory = static_cast<char*>(::operator new(size));  //throws bad_alloc when out of memory
+                m_slabs.push_back({memory, size});
+            }
+            size_t start = (m_used + alignment - 1) & ~(alignment - 1);
+            if (start + bytes <= m_slabs[m_current].m_size) {
+                m_used = start + bytes;
+                return m_slabs[m_current].m_memory + start;
+            }
+            m_current++; //the rest of this slab goes unused until the next reset
+            m_used = 0;
+        }
+    }
+    std::string_view copy(std::string_view s)  //s's characters, copied into the arena
+    {
+        char* memory = static_cast<char*>(allocate(s.length(), 1));
+        memcpy(memory, s.data(), s.length());
+        return std::string_view(memory, s.length());
+    }
+    void reset()  //everything allocated so far is invalid afterwards
+    {
+        m_current = 0;
+        m_used = 0;
+    }
+    int slabCount() const
+    {
+        return m_slabs.size();
+    }
+      // We prevent an Arena object from being copied or assigned.
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+private:
+    struct Slab{
+        char* m_memory;
+        size_t m_size;
+    };
+    std::vector<Slab> m_slabs;
+    size_t m_slabSize;
+    int m_current;  //slab being bumped through
+    size_t m_used;  //bytes of it handed out
+};
+
+//MyHash allocation policy that carves its tables out of an Arena. Tables are never freed one by one: a table
+//outgrown by a rehash or dropped by MyHash::reset stays in the arena until the arena is reset or destroyed, which
+//must not happen while a MyHash still uses it. Only items that need destroying are destroyed; MyHash skips
+//deallocate altogether for tables of trivially destructible items, so dropping one costs nothing.
+class ArenaAllocator
+{
+public:
+    static const bool FREES_MEMORY = false;
+    ArenaAllocator(Arena& arena): m_arena(&arena) {}
+    template <typename T>
+    T* allocate(int n)
+    {
+        T* items = static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T)));
+        for (int i = 0; i < n; i++) {
+            new (items + i) T();
+        }
+        return items;
+    }
+    template <typename T>
+    void deallocate(T* items, int n)
+    {
+        for (int i = 0; i < n; i++) {
+            items[i].~T();
+        }
+    }
+private:
+    Arena* m_arena;
+};
+
+#endif /* Arena_h */
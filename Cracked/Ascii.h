@@ -0,0 +1,162 @@
+//
+//  Ascii.h
+//  Cracked
+//
+
+#ifndef Ascii_h
+#define Ascii_h
+
+#include <string_view>
+#include <cstring>
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+//Validation and normalization of words, with the same results as isalpha and toupper in the "C" locale but
+//without their locale lookups. Strings are scanned 32 bytes at a time with AVX2 when the compiler targets it
+//(-mavx2 or -march=native), 16 at a time with SSE2 (every x86-64 build), and one byte at a time through a
+//lookup table for whatever is left, which is all of a typical word.
+
+const unsigned char ASCII_LETTER = 1;
+const unsigned char ASCII_APOSTROPHE = 2;
+const unsigned char ASCII_UNKNOWN = 4;  //'?', an untranslated letter
+
+struct AsciiClasses{
+    unsigned char m_classes[256];
+    constexpr AsciiClasses(): m_classes{}
+    {
+        for (int c = 'A'; c <= 'Z'; c++) {
+            m_classes[c] = ASCII_LETTER;
+            m_classes[c + 'a' - 'A'] = ASCII_LETTER;
+        }
+        m_classes[(unsigned char)'\''] = ASCII_APOSTROPHE;
+        m_classes[(unsigned char)'?'] = ASCII_UNKNOWN;
+    }
+};
+
+constexpr AsciiClasses ASCII_CLASSES;
+
+inline unsigned char asciiClass(char ch)
+{
+    return ASCII_CLASSES.m_classes[(unsigned char)ch];
+}
+
+inline bool isLetter(char ch)
+{
+    return asciiClass(ch) == ASCII_LETTER;
+}
+
+//true if every character of s is a letter or an apostrophe, or also '?' when allowUnknowns
+inline bool onlyWordCharacters(std::string_view s, bool allowUnknowns)
+{
+    const char* p = s.data();
+    size_t n = s.length();
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i lowerBit32 = _mm256_set1_epi8(0x20);
+    const __m256i beforeA32 = _mm256_set1_epi8('a' - 1);
+    const __m256i afterZ32 = _mm256_set1_epi8('z' + 1);
+    const __m256i apostrophe32 = _mm256_set1_epi8('\'');
+    const __m256i unknown32 = _mm256_set1_epi8(allowUnknowns ? '?' : '\'');
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+        __m256i lower = _mm256_or_si256(v, lowerBit32);  //folds case; bytes past 127 are negative, so never letters
+        __m256i ok = _mm256_and_si256(_mm256_cmpgt_epi8(lower, beforeA32), _mm256_cmpgt_epi8(afterZ32, lower));
+        ok = _mm256_or_si256(ok, _mm256_or_si256(_mm256_cmpeq_epi8(v, apostrophe32), _mm256_cmpeq_epi8(v, unknown32)));
+        if (_mm256_movemask_epi8(ok) != -1) {
+            return false;
+        }
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i lowerBit = _mm_set1_epi8(0x20);
+    const __m128i beforeA = _mm_set1_epi8('a' - 1);
+    const __m128i afterZ = _mm_set1_epi8('z' + 1);
+    const __m128i apostrophe = _mm_set1_epi8('\'');
+    const __m128i unknown = _mm_set1_epi8(allowUnknowns ? '?' : '\'');
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i lower = _mm_or_si128(v, lowerBit);
+        __m128i ok = _mm_and_si128(_mm_cmpgt_epi8(lower, beforeA), _mm_cmplt_epi8(lower, afterZ));
+        ok = _mm_or_si128(ok, _mm_or_si128(_mm_cmpeq_epi8(v, apostrophe), _mm_cmpeq_epi8(v, unknown)));
+        if (_mm_movemask_epi8(ok) != 0xFFFF) {
+            return false;
+        }
+    }
+#endif
+    unsigned char allowed = ASCII_LETTER | ASCII_APOSTROPHE | (allowUnknowns ? ASCII_UNKNOWN : 0);
+    for (; i < n; i++) {
+        if (!(asciiClass(p[i]) & allowed)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//writes s with its lower case letters capitalized to buffer, which holds at least s.length() characters
+inline void upperCase(std::string_view s, char* buffer)
+{
+    const char* p = s.data();
+    size_t n = s.length();
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i beforeLowerA32 = _mm256_set1_epi8('a' - 1);
+    const __m256i afterLowerZ32 = _mm256_set1_epi8('z' + 1);
+    const __m256i caseBit32 = _mm256_set1_epi8(0x20);
+    for (; i + 32 <= n; i += 32) {
+        __m256i v = _mm256_loadu_si256((const __m256i*)(p + i));
+        __m256i lower = _mm256_and_si256(_mm256_cmpgt_epi8(v, beforeLowerA32), _mm256_cmpgt_epi8(afterLowerZ32, v));
+        _mm256_storeu_si256((__m256i*)(buffer + i), _mm256_xor_si256(v, _mm256_and_si256(lower, caseBit32)));
+    }
+#endif
+#if defined(__SSE2__)
+    const __m128i beforeLowerA = _mm_set1_epi8('a' - 1);
+    const __m128i afterLowerZ = _mm_set1_epi8('z' + 1);
+    const __m128i caseBit = _mm_set1_epi8(0x20);
+    for (; i + 16 <= n; i += 16) {
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        __m128i lower = _mm_and_si128(_mm_cmpgt_epi8(v, beforeLowerA), _mm_cmplt_epi8(v, afterLowerZ));
+        _mm_storeu_si128((__m128i*)(buffer + i), _mm_xor_si128(v, _mm_and_si128(lower, caseBit)));
+    }
+#endif
+    for (; i < n; i++) {
+        char ch = p[i];
+        buffer[i] = (ch >= 'a' && ch <= 'z') ? ch - ('a' - 'A') : ch;
+    }
+}
+
+//writes s without its apostrophes to buffer, which holds at least s.length() characters; returns the length written
+inline size_t removeApostrophes(std::string_view s, char* buffer)
+{
+    const char* p = s.data();
+    size_t n = s.length();
+    size_t i = 0;
+    size_t length = 0;
+#if defined(__SSE2__)
+    const __m128i apostrophe = _mm_set1_epi8('\'');
+    for (; i + 16 <= n; i += 16) {  //blocks without an apostrophe, nearly all of them, are copied whole
+        __m128i v = _mm_loadu_si128((const __m128i*)(p + i));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(v, apostrophe)) == 0) {
+            _mm_storeu_si128((__m128i*)(buffer + length), v);
+            length += 16;
+        }
+        else {
+            for (size_t j = i; j < i + 16; j++) {
+                if (p[j] != '\'') {
+                    buffer[length++] = p[j];
+                }
+            }
+        }
+    }
+#endif
+    const char* next;
+    while ((next = (const char*)memchr(p + i, '\'', n - i)) != nullptr) {
+        memmove(buffer + length, p + i, next - (p + i));
+        length += next - (p + i);
+        i = next - p + 1;
+    }
+    memmove(buffer + length, p + i, n - i);
+    return length + n - i;
+}
+
+#endif /* Ascii_h */
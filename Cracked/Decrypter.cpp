@@ -1,112 +1,684 @@
 #include "provided.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <algorithm>
+#include <cctype>
+#include <numeric>
+#include <chrono>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <queue>
+#include <cmath>
+#include <cstdint>
+#include <unordered_set>
+#include <unordered_map>
+#include "ThreadPool.h"
 using namespace std;
 
-class DecrypterImpl
+const unsigned int ALL_LETTERS = (1u << 26) - 1;
+
+//Everything the search needs to know about a ciphertext that never changes while cracking it,
+//worked out once per crack instead of re-tokenizing and rescanning the message at every search node.
+class PreparedCiphertext
 {
 public:
-    DecrypterImpl();
-    bool load(string filename);
-    vector<string> crack(const string& ciphertext);
+    struct CipherWord{ //a distinct token of the ciphertext
+        string m_text;
+        string m_pattern;  //letter pattern, e.g. "ABCCBA"; apostrophes are kept and other characters dropped
+        int m_multiplicity;  //number of times the token occurs
+        unsigned int m_letters;  //bit c is set when ciphertext letter 'A' + c occurs in the token
+        unsigned char m_letterCounts[26];  //occurrences of each ciphertext letter in the token
+        int m_unknowns;  //'?' characters in the ciphertext itself, which never get translated
+        bool m_lettersOnly;  //only letters and apostrophes, so once translated it must be one of its candidates
+        vector<int> m_positions;  //where each occurrence starts in the ciphertext
+    };
+    struct CheckedWord{ //run of letters, '?' and apostrophes, which must be in the word list once completely translated
+        int m_start;
+        int m_length;
+        unsigned int m_letters;  //ciphertext letters in the run
+        bool m_hasUnknown;  //the ciphertext itself contains '?', so the run is never complete
+    };
+    PreparedCiphertext(const string& ciphertext, const Tokenizer& tokenizer);
+    const string& text() const;
+    const vector<CipherWord>& words() const;  //in order of first occurrence
+    const vector<CheckedWord>& checkedWords() const;
+    const vector<int>& letterPositions(int c) const;  //where ciphertext letter 'A' + c occurs in the message
+    const vector<int>& checkedWordsWithLetter(int c) const;  //indices into checkedWords() of the runs containing 'A' + c
+    const vector<int>& wordsWithLetter(int c) const;  //indices into words() of the letters-only words containing 'A' + c
 private:
-    WordList m_wl;
-    Tokenizer m_tn;
-    Translator m_ts;
-    int unTranslated(string s) const;
-    string mostUntranslated(vector<string>& words) const;
-    bool completelyTranslated(vector<string>& cipherwords) const;
-    bool containsBadWord(string oldTranslation, string newTranslation) const;
-    bool isCompleteTranslation(string s) const;
-    bool notInList(string s) const;
-    void crackHelper(string ciphertext, vector<string>& output);
+    string m_ciphertext;
+    vector<CipherWord> m_words;
+    vector<CheckedWord> m_checkedWords;
+    vector<int> m_letterPositions[26];
+    vector<int> m_checkedWordsWithLetter[26];
+    vector<int> m_wordsWithLetter[26];
 };
 
-//Public Method Implementations
-DecrypterImpl::DecrypterImpl(): m_tn(" 0123456789,;:.!()[]{}-\"#$%^&")
+PreparedCiphertext::PreparedCiphertext(const string& ciphertext, const Tokenizer& tokenizer): m_ciphertext(ciphertext)
 {
-    
+    vector<string_view> tokens;
+    tokenizer.tokenize(ciphertext, tokens);
+    unordered_map<string_view, int> wordIndex;  //index into m_words of each distinct token
+    for (int i = 0; i < tokens.size(); i++) {
+        int start = tokens[i].data() - ciphertext.data(); //tokens are views into ciphertext
+        auto found = wordIndex.emplace(tokens[i], m_words.size());
+        if (!found.second) {
+            m_words[found.first->second].m_multiplicity++;
+            m_words[found.first->second].m_positions.push_back(start);
+            continue;
+        }
+        CipherWord word;
+        word.m_text = string(tokens[i]);
+        word.m_multiplicity = 1;
+        word.m_letters = 0;
+        word.m_unknowns = 0;
+        word.m_lettersOnly = true;
+        word.m_positions.push_back(start);
+        char patternLetter[26] = {};
+        char next = 'A';
+        for (int c = 0; c < 26; c++) {
+            word.m_letterCounts[c] = 0;
+        }
+        for (int j = 0; j < tokens[i].length(); j++) {
+            char ch = tokens[i][j];
+            if (isalpha(ch)) {
+                int c = toupper(ch) - 'A';
+                if (patternLetter[c] == 0) {
+                    patternLetter[c] = next++;
+                }
+                word.m_pattern += patternLetter[c];
+                word.m_letters |= 1u << c;
+                word.m_letterCounts[c]++;
+            }
+            else if (ch == '\'') {
+                word.m_pattern += ch;
+            }
+            else {
+                if (ch == '?') {
+                    word.m_unknowns++;
+                }
+                word.m_lettersOnly = false;
+            }
+        }
+        m_words.push_back(word);
+    }
+    for (int w = 0; w < m_words.size(); w++) {
+        for (int c = 0; c < 26; c++) {
+            if (m_words[w].m_lettersOnly && (m_words[w].m_letters & (1u << c))) {
+                m_wordsWithLetter[c].push_back(w);
+            }
+        }
+    }
+    CheckedWord checked = {0, 0, 0, false};
+    for (int i = 0; i <= ciphertext.length(); i++) {
+        if (i < ciphertext.length() && (isalpha(ciphertext[i]) || ciphertext[i] == '?' || ciphertext[i] == '\'')) {
+            if (checked.m_length == 0) {
+                checked = {i, 0, 0, false};
+            }
+            checked.m_length++;
+            if (isalpha(ciphertext[i])) {
+                int c = toupper(ciphertext[i]) - 'A';
+                m_letterPositions[c].push_back(i);
+                checked.m_letters |= 1u << c;
+            }
+            else if (ciphertext[i] == '?') {
+                checked.m_hasUnknown = true;
+            }
+        }
+        else if (checked.m_length != 0) {
+            for (int c = 0; c < 26; c++) {
+                if (checked.m_letters & (1u << c)) {
+                    m_checkedWordsWithLetter[c].push_back(m_checkedWords.size());
+                }
+            }
+            m_checkedWords.push_back(checked);
+            checked.m_length = 0;
+        }
+    }
 }
 
-bool DecrypterImpl::load(string filename)
+const string& PreparedCiphertext::text() const
 {
-    return m_wl.loadWordList(filename);
+    return m_ciphertext;
 }
 
-vector<string> DecrypterImpl::crack(const string& ciphertext)
+const vector<PreparedCiphertext::CipherWord>& PreparedCiphertext::words() const
 {
-    vector<string> decryptions;
-    crackHelper(ciphertext, decryptions);
-    sort(decryptions.begin(), decryptions.end());
-    return decryptions;
+    return m_words;
 }
 
-//Private Implementations
-int DecrypterImpl::unTranslated(string s) const
+const vector<PreparedCiphertext::CheckedWord>& PreparedCiphertext::checkedWords() const
+{
+    return m_checkedWords;
+}
+
+const vector<int>& PreparedCiphertext::letterPositions(int c) const
+{
+    return m_letterPositions[c];
+}
+
+const vector<int>& PreparedCiphertext::checkedWordsWithLetter(int c) const
+{
+    return m_checkedWordsWithLetter[c];
+}
+
+const vector<int>& PreparedCiphertext::wordsWithLetter(int c) const
+{
+    return m_wordsWithLetter[c];
+}
+
+uint64_t bindingKey(int c, int p) //Zobrist key of binding ciphertext letter 'A' + c to plaintext letter 'A' + p
+{
+    uint64_t x = (c * 26 + p + 1) * 0x9E3779B97F4A7C15ull; //splitmix64: a fixed pseudo-random number per binding
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+//A mapping state exactly: five bits per ciphertext letter, holding its plaintext letter plus one, or 0 while the
+//letter is unbound, twelve letters to a word
+typedef array<uint64_t, 3> PackedMapping;
+
+void toggleBinding(PackedMapping& mapping, int c, int p) //binds ciphertext letter 'A' + c to 'A' + p if it is unbound, or unbinds it
+{
+    mapping[c / 12] ^= uint64_t(p + 1) << (5 * (c % 12));
+}
+
+//Translation of the whole ciphertext, kept up to date one letter at a time as mappings are pushed and popped,
+//so a search node only pays for the letters it binds instead of retranslating and rescanning the message.
+class LiveTranslation
 {
-    int unknowns = 0;
-    string translation = m_ts.getTranslation(s);
-    for (int i = 0; i < translation.length(); i++) {
-        if (translation[i] == '?') {
-            unknowns++;
+public:
+    void reset(const PreparedCiphertext& prepared);
+    //bind every letter of cipherWord that is not bound yet to the corresponding letter of plainWord,
+    //and append each checked word that just became completely translated to completed
+    void push(string_view cipherWord, string_view plainWord, vector<string_view>& completed);
+    void pop();  //unbind the letters bound by the last push
+    const string& translation() const;
+    unsigned int boundLetters() const;  //bit c is set when ciphertext letter 'A' + c has a translation
+    unsigned int lastBound() const;  //letters bound by the last push
+    char plaintextOf(int c) const;  //the capital letter ciphertext letter 'A' + c is bound to
+    //Zobrist hash of the bindings: the XOR of bindingKey over every bound letter, so equal mappings have equal
+    //keys however they were reached, and binding or unbinding a letter costs one XOR
+    uint64_t key() const;
+    const PackedMapping& mapping() const;  //the bindings exactly, for telling apart mappings whose keys collide
+    bool isComplete() const;  //no '?' left anywhere in the translation
+    bool initiallyComplete(vector<string_view>& completed) const;  //words with no letters at all are complete before anything is pushed
+private:
+    const PreparedCiphertext* m_prepared;
+    string m_translation;
+    int m_unknowns;  //number of '?' in m_translation
+    unsigned int m_bound;
+    uint64_t m_key;
+    PackedMapping m_mapping;
+    vector<unsigned int> m_pushed;  //letters bound by each push
+};
+
+void LiveTranslation::reset(const PreparedCiphertext& prepared)
+{
+    m_prepared = &prepared;
+    m_translation = prepared.text();
+    m_unknowns = 0;
+    m_bound = 0;
+    m_key = 0;
+    m_mapping.fill(0);
+    m_pushed.clear();
+    for (int i = 0; i < m_translation.length(); i++) {
+        if (isalpha(m_translation[i])) {
+            m_translation[i] = '?';
+        }
+        if (m_translation[i] == '?') {
+            m_unknowns++;
         }
     }
-    return unknowns;
 }
 
-string DecrypterImpl::mostUntranslated(vector<string>& words) const
+void LiveTranslation::push(string_view cipherWord, string_view plainWord, vector<string_view>& completed)
 {
-    string mostUntranslated = "";
-    for (int i = 0; i < words.size(); i++) {
-        if (unTranslated(words[i]) > unTranslated(mostUntranslated) /*&& visited.find(words[i]) == visited.end()*/) {
-            mostUntranslated = words[i];
+    const string& ciphertext = m_prepared->text();
+    unsigned int newlyBound = 0;
+    for (int i = 0; i < cipherWord.length(); i++) {
+        if (!isalpha(cipherWord[i])) {
+            continue;
+        }
+        int c = toupper(cipherWord[i]) - 'A';
+        if (m_bound & (1u << c)) {
+            continue;
+        }
+        m_bound |= 1u << c;
+        newlyBound |= 1u << c;
+        char p = toupper(plainWord[i]);
+        m_key ^= bindingKey(c, p - 'A');
+        toggleBinding(m_mapping, c, p - 'A');
+        const vector<int>& positions = m_prepared->letterPositions(c);
+        for (int pos : positions) {  //only the characters this letter touches change
+            m_translation[pos] = islower(ciphertext[pos]) ? tolower(p) : p;
+        }
+        m_unknowns -= positions.size();
+    }
+    m_pushed.push_back(newlyBound);
+    const vector<PreparedCiphertext::CheckedWord>& checkedWords = m_prepared->checkedWords();
+    for (int c = 0; c < 26; c++) {
+        if (!(newlyBound & (1u << c))) {
+            continue;
+        }
+        for (int w : m_prepared->checkedWordsWithLetter(c)) {
+            const PreparedCiphertext::CheckedWord& word = checkedWords[w];
+            unsigned int justBound = word.m_letters & newlyBound;
+            if ((justBound & -justBound) == (1u << c) && (word.m_letters & ~m_bound) == 0 && !word.m_hasUnknown) { //report each word once, from its lowest newly bound letter
+                completed.push_back(string_view(m_translation).substr(word.m_start, word.m_length));
+            }
+        }
+    }
+}
+
+void LiveTranslation::pop()
+{
+    unsigned int newlyBound = m_pushed.back();
+    m_pushed.pop_back();
+    m_bound &= ~newlyBound;
+    for (int c = 0; c < 26; c++) {
+        if (newlyBound & (1u << c)) {
+            const vector<int>& positions = m_prepared->letterPositions(c);
+            m_key ^= bindingKey(c, plaintextOf(c) - 'A');
+            toggleBinding(m_mapping, c, plaintextOf(c) - 'A');
+            for (int pos : positions) {
+                m_translation[pos] = '?';
+            }
+            m_unknowns += positions.size();
         }
     }
-    return mostUntranslated; //if an empty string is returned, then that means we are out of options
 }
 
-bool DecrypterImpl::containsBadWord(string oldTranslation, string newTranslation)const
+const string& LiveTranslation::translation() const
+{
+    return m_translation;
+}
+
+unsigned int LiveTranslation::boundLetters() const
+{
+    return m_bound;
+}
+
+unsigned int LiveTranslation::lastBound() const
 {
-    if (oldTranslation.length() != newTranslation.length()) {
+    return m_pushed.back();
+}
+
+char LiveTranslation::plaintextOf(int c) const
+{
+    return toupper(m_translation[m_prepared->letterPositions(c)[0]]);
+}
+
+uint64_t LiveTranslation::key() const
+{
+    return m_key;
+}
+
+const PackedMapping& LiveTranslation::mapping() const
+{
+    return m_mapping;
+}
+
+bool LiveTranslation::isComplete() const
+{
+    return m_unknowns == 0;
+}
+
+bool LiveTranslation::initiallyComplete(vector<string_view>& completed) const
+{
+    const vector<PreparedCiphertext::CheckedWord>& checkedWords = m_prepared->checkedWords();
+    for (int w = 0; w < checkedWords.size(); w++) {
+        if (checkedWords[w].m_letters == 0 && !checkedWords[w].m_hasUnknown) {
+            completed.push_back(string_view(m_translation).substr(checkedWords[w].m_start, checkedWords[w].m_length));
+        }
+    }
+    return !completed.empty();
+}
+
+const long DEADLINE_CHECK_INTERVAL = 64;  //search nodes between looks at the clock
+
+//The limits of one crack, shared by every Searcher working on it. The counts are atomic, so searchers on
+//different threads draw from the same budget, and once it is used up all of them stop.
+class SearchBudget
+{
+public:
+    SearchBudget(const CrackLimits& limits);
+    bool expand();  //count a search node; false if the search has to stop instead
+    //count a decryption and pass it on; false if it must be dropped, because it is over the cap or because some
+    //searcher of this crack recorded it already
+    bool record(const string& decryption);
+    bool stopped() const;
+      // We prevent a SearchBudget object from being copied or assigned.
+    SearchBudget(const SearchBudget&) = delete;
+    SearchBudget& operator=(const SearchBudget&) = delete;
+private:
+    const CrackLimits& m_limits;
+    atomic<long> m_nodes;
+    long m_results;  //guarded by m_recordLock
+    atomic<bool> m_stopped;
+    mutex m_recordLock;  //guards m_recorded and serializes the callback
+    unordered_set<string> m_recorded;  //every decryption recorded, so each is output once however many paths reach it
+};
+
+SearchBudget::SearchBudget(const CrackLimits& limits): m_limits(limits), m_nodes(0), m_results(0), m_stopped(false)
+{
+    
+}
+
+bool SearchBudget::expand()
+{
+    if (m_stopped.load(memory_order_relaxed)) {
+        return false;
+    }
+    long nodes = m_nodes.fetch_add(1, memory_order_relaxed) + 1;
+    if (m_limits.m_maxNodes != 0 && nodes > m_limits.m_maxNodes) {
+        m_stopped = true;
+        return false;
+    }
+    if (nodes % DEADLINE_CHECK_INTERVAL == 1 && m_limits.m_deadline != chrono::steady_clock::time_point::max() && chrono::steady_clock::now() >= m_limits.m_deadline) {
+        m_stopped = true;
+        return false;
+    }
+    return true;
+}
+
+bool SearchBudget::record(const string& decryption)
+{
+    lock_guard<mutex> guard(m_recordLock);
+    if (!m_recorded.insert(decryption).second) {
+        return false;
+    }
+    if (m_limits.m_maxResults != 0 && m_results >= m_limits.m_maxResults) { //another searcher got there first
+        m_stopped = true;
+        return false;
+    }
+    if (++m_results == m_limits.m_maxResults) { //stop right away rather than search on for one more: the search
+        m_stopped = true;                        //can't tell the rest of the tree is empty without searching it
+    }
+    if (m_limits.m_onDecryption) {
+        if (!m_limits.m_onDecryption(decryption)) {
+            m_stopped = true;
+        }
+    }
+    return true;
+}
+
+bool SearchBudget::stopped() const
+{
+    return m_stopped.load(memory_order_relaxed);
+}
+
+const int MIN_TRANSPOSITION_SLOTS = 1 << 10;
+const int MAX_TRANSPOSITION_SLOTS = 1 << 16;  //2 MB per searcher
+
+const int TRANSPOSITION_PROBES = 8;  //slots a key may be stored in, starting at its own
+
+//The mapping states a search has already been through. The same mapping can be reached twice, for instance
+//through a word listed twice in the word list, and its subtree only needs searching once. A state goes in the
+//first free slot of the TRANSPOSITION_PROBES starting at its key's own. Below MAX_TRANSPOSITION_SLOTS the table
+//doubles when it is more than half full or a state finds no free slot, so it forgets nothing; at that size, a
+//state with no free slot replaces the one in its key's own slot, so a forgotten state is searched again but
+//memory stays bounded. A slot keeps the whole mapping next to its key, and a state only counts as visited when
+//both match: two mappings whose keys collide are told apart, so a subtree is never skipped unsearched.
+class TranspositionTable
+{
+public:
+    TranspositionTable();
+    bool visit(uint64_t key, const PackedMapping& mapping);  //false if mapping was visited already, otherwise remembers it
+    void clear();
+private:
+    struct Entry{
+        uint64_t m_key;  //0 is an empty slot
+        PackedMapping m_mapping;
+    };
+    vector<Entry> m_slots;
+    int m_used;
+    bool insert(const Entry& entry);  //false if the entry's probes are all taken by other states
+    void grow();
+};
+
+TranspositionTable::TranspositionTable(): m_slots(MIN_TRANSPOSITION_SLOTS, Entry{0, {}}), m_used(0)
+{
+    
+}
+
+bool TranspositionTable::visit(uint64_t key, const PackedMapping& mapping)
+{
+    if (key == 0) { //the empty mapping, which is only ever the root, or a rare collision with it: just search it
         return true;
     }
-    for (int i = 0; i < oldTranslation.length(); i++) {
-        if ((isalpha(oldTranslation[i]) && isalpha(newTranslation[i])) && (oldTranslation[i] != newTranslation[i])) {
+    size_t mask = m_slots.size() - 1;
+    for (int i = 0; i < TRANSPOSITION_PROBES; i++) {
+        const Entry& slot = m_slots[(key + i) & mask];
+        if (slot.m_key == key && slot.m_mapping == mapping) {
+            return false;
+        }
+        if (slot.m_key == 0) {
+            break;
+        }
+    }
+    Entry entry{key, mapping};
+    while (!insert(entry)) {
+        if (m_slots.size() >= MAX_TRANSPOSITION_SLOTS) {
+            m_slots[key & mask] = entry;
+            return true;
+        }
+        grow();
+        mask = m_slots.size() - 1;
+    }
+    if (m_used * 2 > m_slots.size() && m_slots.size() < MAX_TRANSPOSITION_SLOTS) {
+        grow();
+    }
+    return true;
+}
+
+bool TranspositionTable::insert(const Entry& entry)
+{
+    size_t mask = m_slots.size() - 1;
+    for (int i = 0; i < TRANSPOSITION_PROBES; i++) {
+        Entry& slot = m_slots[(entry.m_key + i) & mask];
+        if (slot.m_key == 0) {
+            slot = entry;
+            m_used++;
             return true;
         }
     }
     return false;
 }
 
-bool DecrypterImpl::isCompleteTranslation(string s)const
+void TranspositionTable::clear()
 {
-    for (int i = 0; i < s.length(); i++) {
-        if (s[i] == '?') {
-            return false;
+    m_slots.assign(MIN_TRANSPOSITION_SLOTS, Entry{0, {}});
+    m_used = 0;
+}
+
+void TranspositionTable::grow()
+{
+    vector<Entry> old(m_slots.size() * 2, Entry{0, {}});
+    old.swap(m_slots);
+    m_used = 0;
+    for (int i = 0; i < old.size(); i++) {
+        if (old[i].m_key != 0 && !insert(old[i]) && m_slots.size() < MAX_TRANSPOSITION_SLOTS) { //too crowded still: start over, twice as big
+            m_slots.assign(m_slots.size() * 2, Entry{0, {}});
+            m_used = 0;
+            i = -1;
         }
     }
-    return true;
 }
 
-bool DecrypterImpl::notInList(string s)const
+//A sequence of (ciphertext word, plaintext word) mappings pushed from the root of the search
+typedef vector<pair<string, string>> SearchPath;
+
+//One depth-first search over the candidate words of a prepared ciphertext. Threads cracking the same message
+//each own a Searcher, with its own mapping state, and share the read-only word list and prepared ciphertext.
+class Searcher
 {
-    vector<string> words;
-    string temp = "";
-    for (int i = 0; i < s.length(); i++) {
-        if (isalpha(s[i]) || s[i] == '?' || s[i] == '\'') {
-            temp += s[i];
+public:
+    Searcher(const WordList& wordList, const PreparedCiphertext& prepared, WordOrder order, SearchBudget& budget, CrackStats* stats);
+    void search(vector<string>& output);  //find every decryption reachable from the current mappings
+    void searchFrom(const SearchPath& path, vector<string>& output);  //search only below path, which a previous collectBranches reported
+    //search the top depth levels only, reporting every still-open subtree below them in branches; the decryptions
+    //found on the way are not recorded with the budget, since a deeper split finds them again
+    void collectBranches(int depth, vector<SearchPath>& branches, vector<string>& output);
+    void searchRanked(vector<RankedDecryption>& output);  //best first: the most likely decryptions come out first
+    long nodesExpanded() const;
+      // We prevent a Searcher object from being copied or assigned.
+    Searcher(const Searcher&) = delete;
+    Searcher& operator=(const Searcher&) = delete;
+private:
+    const WordList& m_wl;
+    const PreparedCiphertext& m_prepared;
+    WordOrder m_order;
+    SearchBudget& m_budget;
+    long m_nodes;
+    CrackStats* m_stats;  //where the detailed counts go, or nullptr when nobody asked for them
+    Translator m_ts;
+    LiveTranslation m_live;
+    bool m_alwaysNotInList;  //the ciphertext has a letterless word missing from the word list, so no push can succeed
+    SearchPath m_path;  //mappings pushed so far, only tracked while collecting branches
+    //Letter domains: for each ciphertext letter, bit p is set while 'A' + p could still be its translation. There is
+    //one frame per push, each narrower than the one before it, so a pop just drops the top frame.
+    typedef array<unsigned int, 26> Domains;
+    vector<Domains> m_domains;
+    unsigned int m_messageLetters;  //ciphertext letters occurring in the message
+    vector<int> m_queue;  //words whose candidates may have lost letters, waiting to be revised
+    vector<char> m_queued;
+    vector<unsigned int> m_allowed;  //per-position scratch space for revise
+    vector<unsigned int> m_support;
+    vector<string_view> m_completed;  //words the last push completed
+    TranspositionTable m_visited;  //incomplete mappings already searched
+    vector<double> m_bestLogFrequency;  //for each word, the log frequency of its likeliest candidate at the root of a ranked search
+    int unTranslated(const PreparedCiphertext::CipherWord& word) const;
+    int mostUntranslated() const;
+    int fewestCandidates() const;
+    int chooseWord() const;
+    bool notInList(const vector<string_view>& words) const;
+    bool leftWithoutCandidates() const;
+    bool propagate(unsigned int newlyBound);
+    bool narrow(int c, unsigned int domain);
+    bool revise(int w);
+    bool fitsDomains(string_view cipherWord, string_view plainWord) const;
+    bool pushCandidate(const string& cipherWord, const string& plainWord, bool& viable);
+    bool firstVisit();  //the current mapping hasn't been searched yet; complete mappings always count as new
+    void popCandidate();
+    vector<string> findCandidates(const string& cipherWord, string_view currTranslation);
+    void count(long CrackStats::* counter);
+    chrono::steady_clock::time_point phaseStart() const;
+    void phaseEnd(chrono::steady_clock::time_point start, double CrackStats::* phase);
+    double rankEstimate() const;
+    void crackHelper(vector<string>& output, int depth, vector<SearchPath>* branches);
+};
+
+Searcher::Searcher(const WordList& wordList, const PreparedCiphertext& prepared, WordOrder order, SearchBudget& budget, CrackStats* stats): m_wl(wordList), m_prepared(prepared), m_order(order), m_budget(budget), m_nodes(0), m_stats(stats)
+{
+    vector<string_view> letterless;
+    m_live.reset(prepared);
+    m_alwaysNotInList = m_live.initiallyComplete(letterless) && notInList(letterless);
+    m_messageLetters = 0;
+    for (int c = 0; c < 26; c++) {
+        if (!prepared.letterPositions(c).empty()) {
+            m_messageLetters |= 1u << c;
         }
-        else if (!temp.empty()){
-            if (isCompleteTranslation(temp)) {
-                words.push_back(temp);
-            }
-            temp = "";
+    }
+    m_queued.assign(prepared.words().size(), false);
+    Domains all;
+    all.fill(ALL_LETTERS);
+    m_domains.push_back(all);
+    if (!propagate(0)) { //the root frame: every word narrows its letters to the ones its candidates have
+        m_alwaysNotInList = true;
+    }
+}
+
+void Searcher::search(vector<string>& output)
+{
+    crackHelper(output, -1, nullptr);
+}
+
+void Searcher::searchFrom(const SearchPath& path, vector<string>& output)
+{
+    bool viable;
+    for (int i = 0; i < path.size(); i++) { //every push on path passed its checks while collecting it
+        pushCandidate(path[i].first, path[i].second, viable);
+    }
+    crackHelper(output, -1, nullptr);
+    for (int i = 0; i < path.size(); i++) {
+        popCandidate();
+    }
+}
+
+void Searcher::collectBranches(int depth, vector<SearchPath>& branches, vector<string>& output)
+{
+    m_visited.clear(); //each collection searches the top levels afresh
+    crackHelper(output, depth, &branches);
+}
+
+long Searcher::nodesExpanded() const
+{
+    return m_nodes;
+}
+
+int Searcher::unTranslated(const PreparedCiphertext::CipherWord& word) const
+{
+    int unknowns = word.m_unknowns;
+    unsigned int unbound = word.m_letters & ~m_live.boundLetters();
+    for (int c = 0; unbound != 0; c++, unbound >>= 1) {
+        if (unbound & 1) {
+            unknowns += word.m_letterCounts[c];
         }
     }
-    if (!temp.empty() && isCompleteTranslation(temp)) {
-        words.push_back(temp);
+    return unknowns;
+}
+
+int Searcher::mostUntranslated() const
+{
+    const vector<PreparedCiphertext::CipherWord>& words = m_prepared.words();
+    int mostUntranslated = -1;
+    int mostUnknowns = 0;
+    for (int i = 0; i < words.size(); i++) {
+        int unknowns = unTranslated(words[i]);
+        if (unknowns > mostUnknowns) {
+            mostUntranslated = i;
+            mostUnknowns = unknowns;
+        }
     }
+    return mostUntranslated; //if -1 is returned, then that means we are out of options
+}
+
+int Searcher::fewestCandidates() const
+{
+    const vector<PreparedCiphertext::CipherWord>& words = m_prepared.words();
+    int fewestCandidates = -1;
+    int fewest = 0;
+    int mostCovered = 0;
+    for (int i = 0; i < words.size(); i++) {
+        if (unTranslated(words[i]) == 0) { //the same words mostUntranslated chooses from
+            continue;
+        }
+        string_view currTranslation = string_view(m_live.translation()).substr(words[i].m_positions[0], words[i].m_text.length());
+        int candidates = m_wl.countCandidates(words[i].m_text, currTranslation);
+        int covered = __builtin_popcount(words[i].m_letters & ~m_live.boundLetters());
+        if (fewestCandidates == -1 || candidates < fewest || (candidates == fewest && covered > mostCovered)) {
+            fewestCandidates = i;
+            fewest = candidates;
+            mostCovered = covered;
+            if (fewest == 0) { //this word can't be translated, so the node is a dead end whichever word comes first
+                break;
+            }
+        }
+    }
+    return fewestCandidates;
+}
+
+int Searcher::chooseWord() const
+{
+    return m_order == FEWEST_CANDIDATES ? fewestCandidates() : mostUntranslated();
+}
+
+bool Searcher::notInList(const vector<string_view>& words)const
+{
     for (int i = 0; i < words.size(); i++){
         if (!m_wl.contains(words[i])) {
             return true;
@@ -115,32 +687,614 @@ bool DecrypterImpl::notInList(string s)const
     return false;
 }
 
-void DecrypterImpl::crackHelper(string ciphertext, vector<string>& output)
+//Forward checking: a partially translated word with no candidates left can never be completed, so the push that
+//caused it is a dead end. Only words containing a letter the last push bound can have lost candidates.
+bool Searcher::leftWithoutCandidates() const
+{
+    const vector<PreparedCiphertext::CipherWord>& words = m_prepared.words();
+    unsigned int newlyBound = m_live.lastBound();
+    unsigned int bound = m_live.boundLetters();
+    for (int c = 0; c < 26; c++) {
+        if (!(newlyBound & (1u << c))) {
+            continue;
+        }
+        for (int w : m_prepared.wordsWithLetter(c)) {
+            const PreparedCiphertext::CipherWord& word = words[w];
+            unsigned int justBound = word.m_letters & newlyBound;
+            if ((justBound & -justBound) != (1u << c) || (word.m_letters & ~bound) == 0) { //check each word once; complete words were checked by notInList
+                continue;
+            }
+            string_view currTranslation = string_view(m_live.translation()).substr(word.m_positions[0], word.m_text.length());
+            if (!m_wl.hasCandidates(word.m_text, currTranslation)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+//Arc consistency over the letter domains. A new frame is pushed with the letters just bound fixed, and their
+//translations taken out of every other domain, since no two ciphertext letters share a translation. Each
+//affected word then narrows its letters' domains to the letters its fitting candidates have there, until nothing
+//changes. Returns false if a domain empties, a word has no fitting candidate left, or the unbound letters have
+//fewer possible translations between them than there are letters.
+bool Searcher::propagate(unsigned int newlyBound)
+{
+    m_domains.push_back(m_domains.back());
+    for (int w : m_queue) { //left over from a propagation that failed part way
+        m_queued[w] = false;
+    }
+    m_queue.clear();
+    Domains& domains = m_domains.back();
+    const vector<PreparedCiphertext::CipherWord>& words = m_prepared.words();
+    unsigned int bound = m_live.boundLetters();
+    for (int c = 0; c < 26; c++) {
+        if (newlyBound & (1u << c)) {
+            unsigned int plaintext = 1u << (m_live.plaintextOf(c) - 'A');
+            if (!(domains[c] & plaintext)) {
+                return false;
+            }
+            domains[c] = plaintext;
+            for (int d = 0; d < 26; d++) {
+                if ((m_messageLetters & ~bound & (1u << d)) && !narrow(d, domains[d] & ~plaintext)) {
+                    return false;
+                }
+            }
+        }
+    }
+    for (int w = 0; w < words.size(); w++) { //the root revises every word, later frames only those with a newly bound letter
+        if (words[w].m_lettersOnly && (newlyBound == 0 || (words[w].m_letters & newlyBound)) && !m_queued[w]) {
+            m_queued[w] = true;
+            m_queue.push_back(w);
+        }
+    }
+    for (int next = 0; next < m_queue.size(); next++) {
+        int w = m_queue[next];
+        m_queued[w] = false;
+        if (!revise(w)) {
+            return false;
+        }
+    }
+    m_queue.clear();
+    unsigned int unbound = m_messageLetters & ~bound;
+    unsigned int possible = 0;
+    for (int c = 0; c < 26; c++) {
+        if (unbound & (1u << c)) {
+            possible |= domains[c];
+        }
+    }
+    return __builtin_popcount(possible) >= __builtin_popcount(unbound);
+}
+
+//Shrinks the domain of unbound letter 'A' + c, queueing its words to be revised. A letter left with a single
+//possible translation keeps it to itself, so it is taken out of every other unbound letter's domain.
+bool Searcher::narrow(int c, unsigned int domain)
 {
-    vector<string> words = m_tn.tokenize(ciphertext); //tokenize ciphertext
-    string mostUnknown = mostUntranslated(words); //get the word with the least known characters in its translations
-    string currTranslation = m_ts.getTranslation(mostUnknown); //get current translation for chosen word
-    vector<string> candidates = m_wl.findCandidates(mostUnknown, currTranslation); //obtain all candidates that can possibly match chosen word and compare each one with the word's current translation.
-    for (int i = 0; i < candidates.size(); i++) {  //for each candidate
-        string oldTranslation = m_ts.getTranslation(ciphertext);
-        if (m_ts.pushMapping(mostUnknown, candidates[i])) {  //if progress was made
-            string newTranslation = m_ts.getTranslation(ciphertext); //translate rest of text
-            if (containsBadWord(oldTranslation, newTranslation) || notInList(newTranslation)) {
-                m_ts.popMapping();
+    Domains& domains = m_domains.back();
+    if (domain == domains[c]) {
+        return true;
+    }
+    domains[c] = domain;
+    if (domain == 0) {
+        return false;
+    }
+    for (int w : m_prepared.wordsWithLetter(c)) {
+        if (!m_queued[w]) {
+            m_queued[w] = true;
+            m_queue.push_back(w);
+        }
+    }
+    if ((domain & (domain - 1)) == 0) {
+        unsigned int others = m_messageLetters & ~m_live.boundLetters() & ~(1u << c);
+        for (int d = 0; d < 26; d++) {
+            if ((others & (1u << d)) && (domains[d] & domain) && !narrow(d, domains[d] & ~domain)) {
+                return false;
             }
-            else if (isCompleteTranslation(newTranslation)){
-                output.push_back(newTranslation);
-                m_ts.popMapping();
+        }
+    }
+    return true;
+}
+
+bool Searcher::revise(int w)
+{
+    const PreparedCiphertext::CipherWord& word = m_prepared.words()[w];
+    unsigned int unbound = word.m_letters & ~m_live.boundLetters();
+    if (unbound == 0) { //complete words were checked by notInList
+        return true;
+    }
+    const Domains& domains = m_domains.back();
+    int length = word.m_text.length();
+    m_allowed.resize(length);
+    m_support.resize(length);
+    for (int j = 0; j < length; j++) {
+        m_allowed[j] = isalpha(word.m_text[j]) ? domains[toupper(word.m_text[j]) - 'A'] : ALL_LETTERS;
+    }
+    string_view currTranslation = string_view(m_live.translation()).substr(word.m_positions[0], length);
+    if (m_wl.candidateLetters(word.m_text, currTranslation, m_allowed.data(), m_support.data()) == 0) {
+        return false;
+    }
+    for (int j = 0; j < length; j++) {
+        if (isalpha(word.m_text[j])) {
+            int c = toupper(word.m_text[j]) - 'A';
+            if ((unbound & (1u << c)) && !narrow(c, m_domains.back()[c] & m_support[j])) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool Searcher::fitsDomains(string_view cipherWord, string_view plainWord) const //could plainWord be what cipherWord translates to?
+{
+    const Domains& domains = m_domains.back();
+    for (int j = 0; j < cipherWord.length(); j++) {
+        if (isalpha(cipherWord[j]) && !(domains[toupper(cipherWord[j]) - 'A'] & (1u << (toupper(plainWord[j]) - 'A')))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Searcher::crackHelper(vector<string>& output, int depth, vector<SearchPath>* branches)
+{
+    if (branches != nullptr && depth == 0) { //hand the rest of this subtree to whoever collects the branches
+        branches->push_back(m_path);
+        return;
+    }
+    if (!m_budget.expand()) {
+        return;
+    }
+    m_nodes++;
+    int chosen = chooseWord(); //get the word to branch on next: by default the one with the least known characters in its translations
+    string mostUnknown;
+    string_view currTranslation;
+    if (chosen != -1) {
+        const PreparedCiphertext::CipherWord& word = m_prepared.words()[chosen];
+        mostUnknown = word.m_text;
+        currTranslation = string_view(m_live.translation()).substr(word.m_positions[0], word.m_text.length()); //current translation for chosen word
+    }
+    vector<string> candidates = findCandidates(mostUnknown, currTranslation); //obtain all candidates that can possibly match chosen word and compare each one with the word's current translation.
+    bool viable;
+    for (int i = 0; i < candidates.size() && !m_budget.stopped(); i++) {  //for each candidate
+        if (!pushCandidate(mostUnknown, candidates[i], viable)) {
+            continue;
+        }
+        if (viable && firstVisit()) {
+            if (m_live.isComplete()) {
+                if (branches != nullptr || m_budget.record(m_live.translation())) {
+                    output.push_back(m_live.translation());
+                }
             }
             else {
-                crackHelper(ciphertext, output);
+                if (branches != nullptr) {
+                    m_path.push_back({mostUnknown, candidates[i]});
+                }
+                crackHelper(output, depth - 1, branches);
+                if (branches != nullptr) {
+                    m_path.pop_back();
+                }
             }
         }
+        popCandidate();
+    }
+}
+
+//Pushes plainWord as the translation of cipherWord. Returns false if it conflicts with the current mapping or
+//domains, in which case nothing is pushed; otherwise sets viable to whether the result passed every check, and
+//popCandidate has to undo it either way.
+bool Searcher::pushCandidate(const string& cipherWord, const string& plainWord, bool& viable)
+{
+    auto start = phaseStart();
+    if (!fitsDomains(cipherWord, plainWord)) { //rejected before anything is translated
+        count(&CrackStats::m_rejectedByDomains);
+        phaseEnd(start, &CrackStats::m_checkMs);
+        return false;
+    }
+    if (!m_ts.canPushMapping(cipherWord, plainWord)) { //checked on views, so a conflicting candidate copies nothing
+        count(&CrackStats::m_rejectedConflicting);
+        phaseEnd(start, &CrackStats::m_checkMs);
+        return false;
+    }
+    m_ts.pushMapping(cipherWord, plainWord);
+    m_completed.clear();
+    m_live.push(cipherWord, plainWord, m_completed); //translate only the letters this candidate binds
+    int frames = m_domains.size();
+    viable = false;
+    if (m_alwaysNotInList || notInList(m_completed)) { //words completed earlier were already checked
+        count(&CrackStats::m_prunedNotInList);
+    }
+    else if (leftWithoutCandidates()) {
+        count(&CrackStats::m_prunedNoCandidates);
+    }
+    else if (!m_live.isComplete() && !propagate(m_live.lastBound())) {
+        count(&CrackStats::m_prunedByPropagation);
+    }
+    else {
+        viable = true;
+    }
+    if (m_domains.size() == frames) { //every push gets a domain frame, so popCandidate always drops one
+        m_domains.push_back(m_domains.back());
+    }
+    if (m_stats != nullptr) {
+        m_stats->m_pushes++;
+        m_stats->m_maxDepth = max(m_stats->m_maxDepth, int(m_domains.size()) - 1);
     }
+    phaseEnd(start, &CrackStats::m_checkMs);
+    return true;
+}
+
+bool Searcher::firstVisit()
+{
+    if (m_live.isComplete()) { //SearchBudget::record drops a repeated decryption exactly, by its text
+        return true;
+    }
+    bool first = m_visited.visit(m_live.key(), m_live.mapping());
+    if (!first) {
+        count(&CrackStats::m_prunedRepeated);
+    }
+    return first;
+}
+
+void Searcher::popCandidate()
+{
+    count(&CrackStats::m_pops);
+    m_domains.pop_back();
+    m_live.pop();
     m_ts.popMapping();
 }
 
+vector<string> Searcher::findCandidates(const string& cipherWord, string_view currTranslation)
+{
+    if (m_stats == nullptr) {
+        return m_wl.findCandidates(cipherWord, currTranslation);
+    }
+    auto start = phaseStart();
+    vector<string> candidates = m_wl.findCandidates(cipherWord, currTranslation);
+    phaseEnd(start, &CrackStats::m_candidatesMs);
+    int bucket = 0;
+    for (size_t n = candidates.size(); n != 0 && bucket < CANDIDATE_HISTOGRAM_BUCKETS - 1; n >>= 1) {
+        bucket++;
+    }
+    m_stats->m_candidateHistogram[bucket]++;
+    return candidates;
+}
 
+void Searcher::count(long CrackStats::* counter)
+{
+    if (m_stats != nullptr) {
+        (m_stats->*counter)++;
+    }
+}
+
+chrono::steady_clock::time_point Searcher::phaseStart() const
+{
+    return m_stats != nullptr ? chrono::steady_clock::now() : chrono::steady_clock::time_point();
+}
+
+void Searcher::phaseEnd(chrono::steady_clock::time_point start, double CrackStats::* phase)
+{
+    if (m_stats != nullptr) {
+        m_stats->*phase += chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+}
+
+//An upper bound on the log probability of any decryption below the current mappings: the exact log frequency of
+//every word already translated, plus the likeliest candidate at the root for every other word. Each occurrence of
+//a word counts, and words with characters other than letters and apostrophes are left out.
+double Searcher::rankEstimate() const
+{
+    const vector<PreparedCiphertext::CipherWord>& words = m_prepared.words();
+    double estimate = 0;
+    for (int w = 0; w < words.size(); w++) {
+        if (!words[w].m_lettersOnly) {
+            continue;
+        }
+        if ((words[w].m_letters & ~m_live.boundLetters()) == 0) {
+            estimate += words[w].m_multiplicity * m_wl.logFrequency(string_view(m_live.translation()).substr(words[w].m_positions[0], words[w].m_text.length()));
+        }
+        else {
+            estimate += words[w].m_multiplicity * m_bestLogFrequency[w];
+        }
+    }
+    return estimate;
+}
+
+//Best-first search: open states wait in a priority queue ordered by rankEstimate. Translating a word can only
+//lower the estimate, so when a complete decryption reaches the front, nothing still waiting can beat it, and the
+//decryptions come out in order of likelihood. States are kept as a tree of (parent, word, candidate) nodes and
+//rebuilt by pushing their path, so only the state being expanded holds a mapping.
+void Searcher::searchRanked(vector<RankedDecryption>& output)
+{
+    const vector<PreparedCiphertext::CipherWord>& words = m_prepared.words();
+    m_bestLogFrequency.assign(words.size(), 0);
+    for (int w = 0; w < words.size(); w++) {
+        if (words[w].m_lettersOnly) {
+            vector<string> candidates = m_wl.findCandidates(words[w].m_text, string_view(m_live.translation()).substr(words[w].m_positions[0], words[w].m_text.length()));
+            m_bestLogFrequency[w] = -HUGE_VAL;
+            for (int i = 0; i < candidates.size(); i++) {
+                m_bestLogFrequency[w] = max(m_bestLogFrequency[w], m_wl.logFrequency(candidates[i]));
+            }
+        }
+    }
+    struct RankedNode{
+        int m_parent;  //-1 for a child of the root
+        string m_cipherWord;
+        string m_plainWord;
+        bool m_complete;  //the mappings down to this node translate the whole message
+        string m_decryption;  //the translation, if complete
+    };
+    struct OpenState{
+        double m_estimate;
+        long m_sequence;  //equal estimates are expanded in the order they were found
+        int m_node;  //-1 for the root
+    };
+    auto later = [](const OpenState& a, const OpenState& b) {
+        return a.m_estimate != b.m_estimate ? a.m_estimate < b.m_estimate : a.m_sequence > b.m_sequence;
+    };
+    priority_queue<OpenState, vector<OpenState>, decltype(later)> open(later);
+    vector<RankedNode> nodes;
+    vector<int> path;
+    long sequence = 0;
+    open.push({rankEstimate(), sequence++, -1});
+    while (!open.empty() && !m_budget.stopped()) {
+        OpenState state = open.top();
+        open.pop();
+        if (state.m_node != -1 && nodes[state.m_node].m_complete) {
+            if (m_budget.record(nodes[state.m_node].m_decryption)) {
+                output.push_back({nodes[state.m_node].m_decryption, state.m_estimate});
+            }
+            continue;
+        }
+        path.clear();
+        for (int n = state.m_node; n != -1; n = nodes[n].m_parent) {
+            path.push_back(n);
+        }
+        bool viable;
+        for (int i = path.size() - 1; i >= 0; i--) { //every push on the path passed its checks when its node was made
+            pushCandidate(nodes[path[i]].m_cipherWord, nodes[path[i]].m_plainWord, viable);
+        }
+        if (m_budget.expand()) {
+            m_nodes++;
+            int chosen = chooseWord();
+            string cipherWord;
+            string_view currTranslation;
+            if (chosen != -1) {
+                cipherWord = words[chosen].m_text;
+                currTranslation = string_view(m_live.translation()).substr(words[chosen].m_positions[0], cipherWord.length());
+            }
+            vector<string> candidates = findCandidates(cipherWord, currTranslation);
+            for (int i = 0; i < candidates.size(); i++) {
+                if (!pushCandidate(cipherWord, candidates[i], viable)) {
+                    continue;
+                }
+                if (viable && firstVisit()) {
+                    nodes.push_back({state.m_node, cipherWord, candidates[i], m_live.isComplete(), m_live.isComplete() ? m_live.translation() : ""});
+                    open.push({rankEstimate(), sequence++, int(nodes.size()) - 1});
+                }
+                popCandidate();
+            }
+        }
+        for (int i = 0; i < path.size(); i++) {
+            popCandidate();
+        }
+    }
+}
+
+const int MAX_SPLIT_DEPTH = 4;  //deepest level a parallel crack splits the search tree at
+const int BRANCHES_PER_THREAD = 16;  //enough subtrees that stealing can even out their very different sizes
+const CrackLimits NO_LIMITS = CrackLimits();
+
+//the CrackStats a search should fill in detail: stats itself, cleared, if its caller asked for details; else nullptr
+CrackStats* detailedStats(CrackStats* stats)
+{
+    if (stats == nullptr || !stats->m_detailed) {
+        return nullptr;
+    }
+    *stats = CrackStats();
+    stats->m_detailed = true;
+    return stats;
+}
+
+//adds the detailed counts of one searcher to those of the whole crack
+void addDetails(CrackStats& total, const CrackStats& part)
+{
+    total.m_pushes += part.m_pushes;
+    total.m_pops += part.m_pops;
+    total.m_rejectedConflicting += part.m_rejectedConflicting;
+    total.m_rejectedByDomains += part.m_rejectedByDomains;
+    total.m_prunedNotInList += part.m_prunedNotInList;
+    total.m_prunedNoCandidates += part.m_prunedNoCandidates;
+    total.m_prunedByPropagation += part.m_prunedByPropagation;
+    total.m_prunedRepeated += part.m_prunedRepeated;
+    for (int b = 0; b < CANDIDATE_HISTOGRAM_BUCKETS; b++) {
+        total.m_candidateHistogram[b] += part.m_candidateHistogram[b];
+    }
+    total.m_maxDepth = max(total.m_maxDepth, part.m_maxDepth);
+    total.m_prepareMs += part.m_prepareMs;
+    total.m_candidatesMs += part.m_candidatesMs;
+    total.m_checkMs += part.m_checkMs;
+}
+
+class DecrypterImpl
+{
+public:
+    DecrypterImpl();
+    bool load(string filename);
+    vector<string> crack(const string& ciphertext, CrackStats* stats) const;
+    vector<string> crack(const string& ciphertext, const CrackLimits& limits, bool* complete, CrackStats* stats) const;
+    vector<RankedDecryption> crackRanked(const string& ciphertext, const CrackLimits& limits, bool* complete, CrackStats* stats) const;
+    vector<vector<string>> crackBatch(const vector<string>& ciphertexts, BatchReport* report) const;
+    void setThreadCount(int threadCount);
+    void setWordOrder(WordOrder order);
+private:
+    WordList m_wl;
+    Tokenizer m_tn;
+    int m_threadCount;
+    WordOrder m_wordOrder;
+    vector<string> crack(const string& ciphertext, int threadCount, const CrackLimits& limits, bool* complete, CrackStats* stats) const;
+    long crackInParallel(const PreparedCiphertext& prepared, int threadCount, SearchBudget& budget, vector<string>& output, CrackStats* detailed) const; //returns the nodes expanded
+};
+
+constexpr CharacterSet CIPHERTEXT_SEPARATORS(" 0123456789,;:.!()[]{}-\"#$%^&");
+
+//Public Method Implementations
+DecrypterImpl::DecrypterImpl(): m_tn(CIPHERTEXT_SEPARATORS), m_threadCount(1), m_wordOrder(MOST_UNTRANSLATED)
+{
+    
+}
+
+bool DecrypterImpl::load(string filename)
+{
+    return m_wl.loadWordList(filename);
+}
+
+vector<string> DecrypterImpl::crack(const string& ciphertext, CrackStats* stats) const
+{
+    return crack(ciphertext, m_threadCount, NO_LIMITS, nullptr, stats);
+}
+
+vector<string> DecrypterImpl::crack(const string& ciphertext, const CrackLimits& limits, bool* complete, CrackStats* stats) const
+{
+    return crack(ciphertext, m_threadCount, limits, complete, stats);
+}
+
+vector<RankedDecryption> DecrypterImpl::crackRanked(const string& ciphertext, const CrackLimits& limits, bool* complete, CrackStats* stats) const
+{
+    auto start = chrono::steady_clock::now();
+    CrackStats* detailed = detailedStats(stats);
+    vector<RankedDecryption> ranked;
+    SearchBudget budget(limits);
+    PreparedCiphertext prepared(ciphertext, m_tn);
+    Searcher searcher(m_wl, prepared, m_wordOrder, budget, detailed); //one thread: the ranking comes from a single priority queue
+    if (detailed != nullptr) {
+        detailed->m_prepareMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+    searcher.searchRanked(ranked);
+    if (complete != nullptr) {
+        *complete = !budget.stopped();
+    }
+    if (stats != nullptr) {
+        stats->m_nodesExpanded = searcher.nodesExpanded();
+        stats->m_wallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+    return ranked;
+}
+
+vector<vector<string>> DecrypterImpl::crackBatch(const vector<string>& ciphertexts, BatchReport* report) const
+{
+    vector<vector<string>> decryptions(ciphertexts.size());
+    vector<double> latencies(ciphertexts.size());
+    vector<int> messages(ciphertexts.size());
+    iota(messages.begin(), messages.end(), 0);
+    auto start = chrono::steady_clock::now();
+    runWorkStealing(messages, m_threadCount, [this, &ciphertexts, &decryptions, &latencies](int, int message) {
+        auto begin = chrono::steady_clock::now();
+        decryptions[message] = crack(ciphertexts[message], 1, NO_LIMITS, nullptr, nullptr); //the threads are already busy with other messages
+        latencies[message] = chrono::duration<double, milli>(chrono::steady_clock::now() - begin).count();
+    });
+    double totalMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    if (report != nullptr) {
+        report->m_latencyMs = latencies;
+        report->m_totalMs = totalMs;
+        report->m_messagesPerSecond = totalMs > 0 ? ciphertexts.size() * 1000.0 / totalMs : 0;
+    }
+    return decryptions;
+}
+
+void DecrypterImpl::setThreadCount(int threadCount)
+{
+    m_threadCount = threadCount < 1 ? 1 : threadCount;
+}
+
+void DecrypterImpl::setWordOrder(WordOrder order)
+{
+    m_wordOrder = order;
+}
+
+//Private Implementations
+vector<string> DecrypterImpl::crack(const string& ciphertext, int threadCount, const CrackLimits& limits, bool* complete, CrackStats* stats) const
+{
+    auto start = chrono::steady_clock::now();
+    CrackStats* detailed = detailedStats(stats);
+    vector<string> decryptions;
+    long nodes;
+    SearchBudget budget(limits);
+    PreparedCiphertext prepared(ciphertext, m_tn); //tokenize ciphertext once for the whole search
+    if (detailed != nullptr) {
+        detailed->m_prepareMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+    if (threadCount > 1) {
+        nodes = crackInParallel(prepared, threadCount, budget, decryptions, detailed);
+    }
+    else {
+        auto setup = chrono::steady_clock::now();
+        Searcher searcher(m_wl, prepared, m_wordOrder, budget, detailed);
+        if (detailed != nullptr) {
+            detailed->m_prepareMs += chrono::duration<double, milli>(chrono::steady_clock::now() - setup).count();
+        }
+        searcher.search(decryptions);
+        nodes = searcher.nodesExpanded();
+    }
+    auto sorting = chrono::steady_clock::now();
+    sort(decryptions.begin(), decryptions.end());
+    if (detailed != nullptr) {
+        detailed->m_sortMs = chrono::duration<double, milli>(chrono::steady_clock::now() - sorting).count();
+    }
+    if (complete != nullptr) {
+        *complete = !budget.stopped();
+    }
+    if (stats != nullptr) {
+        stats->m_nodesExpanded = nodes;
+        stats->m_wallMs = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    }
+    return decryptions;
+}
+
+long DecrypterImpl::crackInParallel(const PreparedCiphertext& prepared, int threadCount, SearchBudget& budget, vector<string>& output, CrackStats* detailed) const
+{
+    vector<CrackStats> parts(threadCount + 1); //one per searcher, the root's last, so the threads never share counters
+    auto part = [detailed, &parts](int i) { return detailed != nullptr ? &parts[i] : nullptr; };
+    auto setup = chrono::steady_clock::now();
+    Searcher root(m_wl, prepared, m_wordOrder, budget, part(threadCount));
+    if (detailed != nullptr) {
+        parts[threadCount].m_prepareMs = chrono::duration<double, milli>(chrono::steady_clock::now() - setup).count();
+    }
+    vector<SearchPath> branches;
+    vector<string> collected;
+    for (int depth = 1; depth <= MAX_SPLIT_DEPTH && !budget.stopped(); depth++) { //split deeper until there are enough subtrees to go around
+        branches.clear();
+        collected.clear();
+        root.collectBranches(depth, branches, collected);
+        if (branches.size() >= threadCount * BRANCHES_PER_THREAD) {
+            break;
+        }
+    }
+    for (int i = 0; i < collected.size(); i++) { //decryptions above the split, found once the split is settled
+        if (budget.record(collected[i])) {
+            output.push_back(collected[i]);
+        }
+    }
+    vector<Searcher*> searchers;
+    vector<vector<string>> found(threadCount);
+    for (int i = 0; i < threadCount; i++) {
+        searchers.push_back(new Searcher(m_wl, prepared, m_wordOrder, budget, part(i)));
+    }
+    runWorkStealing(branches, threadCount, [&searchers, &found](int worker, const SearchPath& branch) {
+        searchers[worker]->searchFrom(branch, found[worker]);
+    });
+    long nodes = root.nodesExpanded(); //includes the levels searched again each time the split went deeper
+    for (int i = 0; i < threadCount; i++) { //merge; crack sorts the result, so it matches the serial search exactly
+        output.insert(output.end(), found[i].begin(), found[i].end());
+        nodes += searchers[i]->nodesExpanded();
+        delete searchers[i];
+    }
+    if (detailed != nullptr) {
+        for (int i = 0; i <= threadCount; i++) {
+            addDetails(*detailed, parts[i]);
+        }
+    }
+    return nodes;
+}
 
 //******************** Decrypter functions ************************************
 
@@ -162,7 +1316,32 @@ bool Decrypter::load(string filename)
     return m_impl->load(filename);
 }
 
-vector<string> Decrypter::crack(const string& ciphertext)
+vector<string> Decrypter::crack(const string& ciphertext, CrackStats* stats) const
+{
+    return m_impl->crack(ciphertext, stats);
+}
+
+vector<string> Decrypter::crack(const string& ciphertext, const CrackLimits& limits, bool* complete, CrackStats* stats) const
+{
+    return m_impl->crack(ciphertext, limits, complete, stats);
+}
+
+vector<RankedDecryption> Decrypter::crackRanked(const string& ciphertext, const CrackLimits& limits, bool* complete, CrackStats* stats) const
+{
+    return m_impl->crackRanked(ciphertext, limits, complete, stats);
+}
+
+vector<vector<string>> Decrypter::crackBatch(const vector<string>& ciphertexts, BatchReport* report) const
+{
+    return m_impl->crackBatch(ciphertexts, report);
+}
+
+void Decrypter::setThreadCount(int threadCount)
+{
+    m_impl->setThreadCount(threadCount);
+}
+
+void Decrypter::setWordOrder(WordOrder order)
 {
-    return m_impl->crack(ciphertext);
+    m_impl->setWordOrder(order);
 }
@@ -10,14 +10,36 @@
 #define MyHash_h
 
 #include <iostream>
+#include <utility>
+#include <type_traits>
 
-const int DEFAULT_HASH_TABLE_SIZE = 100;
+const int DEFAULT_HASH_TABLE_SIZE = 128;  //a power of 2; doubling keeps every table size one, so a bucket is a mask away
+const double MAX_HASH_LOAD_FACTOR = 0.9;   //open addressing needs free slots, so the table can never be completely full
+const int MAX_HASH_PROBE_LENGTH = 255;     //the most a probe length byte holds; an item pushed farther makes the table grow
 
-template<typename KeyType, typename ValueType>
+//Default allocation policy: every table MyHash allocates is its own new[], freed as soon as it is replaced.
+//A policy provides allocate<T>(n), returning n constructed Ts, and deallocate<T>(items, n), and says in
+//FREES_MEMORY whether deallocate gives the memory back; see ArenaAllocator in Arena.h for one that takes its
+//memory from an arena and doesn't.
+struct HeapAllocator{
+    static const bool FREES_MEMORY = true;
+    template <typename T>
+    T* allocate(int n)
+    {
+        return new T[n];
+    }
+    template <typename T>
+    void deallocate(T* items, int /*n*/)
+    {
+        delete [] items;
+    }
+};
+
+template<typename KeyType, typename ValueType, typename Allocator = HeapAllocator>
 class MyHash
 {
 public:
-    MyHash(double maxLoadFactor = 0.5);
+    MyHash(double maxLoadFactor = 0.5, Allocator allocator = Allocator());
     ~MyHash();
     void reset();
     void associate(const KeyType& key, const ValueType& value);
@@ -27,6 +49,15 @@ public:
       // for a map that can't be modified, return a pointer to const ValueType
     const ValueType* find(const KeyType& key) const;
 
+      // heterogeneous lookup: LookupKey can be any type that compares equal to KeyType and has a hash()
+      // giving the same value as KeyType's (e.g. std::string_view for std::string keys), so no KeyType is built
+    template <typename LookupKey, typename = typename std::enable_if<!std::is_convertible<const LookupKey&, KeyType>::value>::type>
+    const ValueType* find(const LookupKey& key) const;
+
+      // lookup with a hash value the caller already computed; hashValue must equal hash(key)
+    template <typename LookupKey>
+    const ValueType* find(const LookupKey& key, unsigned int hashValue) const;
+
       // for a modifiable map, return a pointer to modifiable ValueType
     ValueType* find(const KeyType& key)
     {
@@ -37,172 +68,212 @@ public:
     MyHash(const MyHash&) = delete;
     MyHash& operator=(const MyHash&) = delete;
 private:
+    Allocator m_allocator;
     double m_maxLoadFactor;
     double m_currentLoadFactor;
-    struct Node{ //Node for linked list in each bucket
+    struct Slot{ //one entry of the flat table. Only meaningful when its probe length is nonzero.
         KeyType m_key;
         ValueType m_value;
-        Node* m_next;
     };
-    Node** m_hashTable; 
-    int m_buckets;  //Not guanranteed to not grow past 100.
+    //Robin hood open addressing: every item lives directly in m_slots, and m_probeLengths[i] holds how far
+    //slot i's item sits from its home bucket plus one (0 means the slot is empty). Items that are closer to home
+    //give up their slot to items that are farther from home, which keeps probe sequences short and lets a
+    //search stop as soon as it meets an item closer to home than the key being searched for. The probe lengths
+    //are single bytes in an array of their own, small enough to stay in cache, so a probe only reads a slot
+    //whose item could be the key.
+    Slot* m_slots;
+    unsigned char* m_probeLengths;
+    int m_buckets;  //always a power of 2
     int m_items;
-    unsigned int getBucketNumber(const KeyType& key) const;
+    unsigned int getBucketNumber(unsigned int hashValue) const;
+    void allocate(int buckets); //sets up an empty table with the given number of buckets
     void clear(); //destructor delegates work to this function
     void reHash();  //Rehash is triggered when current load factor exceeds maximum allowed load factor.
+    void place(Slot& item, unsigned int slot, int probeLength); //robin hood insertion of an item known to not be in the table
+    template <typename T>
+    void release(T* items, int n); //hands a table back to the allocator, unless that would do nothing
 };
 
 //MyHash Public Methods Implementation
-template <class KeyType, class ValueType>
-MyHash<KeyType, ValueType>::MyHash(double maxLoadFactor)
+template <class KeyType, class ValueType, class Allocator>
+MyHash<KeyType, ValueType, Allocator>::MyHash(double maxLoadFactor, Allocator allocator): m_allocator(allocator)
 {
     if (maxLoadFactor <= 0.0) {
         maxLoadFactor = 0.5;
     }
-    else if (maxLoadFactor > 2.0){
-        maxLoadFactor = 2.0;
+    else if (maxLoadFactor > MAX_HASH_LOAD_FACTOR){
+        maxLoadFactor = MAX_HASH_LOAD_FACTOR;
     }
     m_maxLoadFactor = maxLoadFactor;
-    m_currentLoadFactor = 0;
-    m_items = 0;
-    m_buckets = DEFAULT_HASH_TABLE_SIZE;
-    m_hashTable = new Node* [m_buckets];
-    for (int i = 0; i < m_buckets; i++) {
-        m_hashTable[i] = nullptr;
-    }
+    allocate(DEFAULT_HASH_TABLE_SIZE);
 }
 
-template <class KeyType, class ValueType>
-MyHash<KeyType, ValueType>::~MyHash()
+template <class KeyType, class ValueType, class Allocator>
+MyHash<KeyType, ValueType, Allocator>::~MyHash()
 {
     clear();
 }
 
-template <class KeyType, class ValueType>
-void MyHash<KeyType, ValueType>::reset()
+//With an allocator that doesn't free memory, such as ArenaAllocator, reset drops the old table without touching
+//its slots one by one; the memory only comes back when the arena itself is reset.
+template <class KeyType, class ValueType, class Allocator>
+void MyHash<KeyType, ValueType, Allocator>::reset()
 {
     clear();
-    m_hashTable = new Node* [DEFAULT_HASH_TABLE_SIZE];
-    m_currentLoadFactor = 0.0;
-    m_items = 0;
+    allocate(DEFAULT_HASH_TABLE_SIZE);
 }
 
-template <class KeyType, class ValueType>
-void MyHash<KeyType, ValueType>::associate(const KeyType& key, const ValueType& value)
+template <class KeyType, class ValueType, class Allocator>
+void MyHash<KeyType, ValueType, Allocator>::associate(const KeyType& key, const ValueType& value)
 {
-    unsigned int hash_key = getBucketNumber(key);
-    Node* p = m_hashTable[hash_key];
-    if (find(key) != nullptr) {
-        while (p != nullptr && p->m_key != key) {
-            p = p->m_next;
+    unsigned int hash(const KeyType& k);  //prototype
+    unsigned int slot = getBucketNumber(hash(key));
+    int probeLength = 1;
+    while (m_probeLengths[slot] >= probeLength) { //single pass: either find the key or the slot where it belongs
+        if (m_probeLengths[slot] == probeLength && m_slots[slot].m_key == key) {
+            m_slots[slot].m_value = value; //update a value for an existing key. No insertions made.
+            return;
         }
-        p->m_value = value; //update a value for an existing key. No insertions made.
+        slot = getBucketNumber(slot + 1);
+        probeLength++;
     }
-    else {
-        m_items++;
-        m_currentLoadFactor = double(m_items)/double(m_buckets);
-        Node* newNode = new Node();
-        newNode->m_key = key;
-        newNode->m_value = value;
-        newNode->m_next = nullptr;
-        if (p == nullptr) {
-            m_hashTable[hash_key] = newNode;
-        }
-        else{
-            while (p->m_next != nullptr) {
-                p = p->m_next;
-            }
-            p->m_next = newNode;
-        }
-        if (m_currentLoadFactor > m_maxLoadFactor) { //rehash triggered if inserting a new item results in the current load factor exceeding the max load factor.
-            reHash();
-        }
+    Slot newItem;
+    newItem.m_key = key;
+    newItem.m_value = value;
+    m_items++;
+    m_currentLoadFactor = double(m_items)/double(m_buckets);
+    place(newItem, slot, probeLength);
+    if (m_currentLoadFactor > m_maxLoadFactor) { //rehash triggered if inserting a new item results in the current load factor exceeding the max load factor.
+        reHash();
     }
 }
 
-template <class KeyType, class ValueType>
-const ValueType* MyHash<KeyType, ValueType>::find(const KeyType& key) const
+template <class KeyType, class ValueType, class Allocator>
+const ValueType* MyHash<KeyType, ValueType, Allocator>::find(const KeyType& key) const
+{
+    unsigned int hash(const KeyType& k);  //prototype
+    return find(key, hash(key));
+}
+
+template <class KeyType, class ValueType, class Allocator>
+template <typename LookupKey, typename>
+const ValueType* MyHash<KeyType, ValueType, Allocator>::find(const LookupKey& key) const
+{
+    unsigned int hash(const LookupKey& k);  //prototype
+    return find(key, hash(key));
+}
+
+template <class KeyType, class ValueType, class Allocator>
+template <typename LookupKey>
+const ValueType* MyHash<KeyType, ValueType, Allocator>::find(const LookupKey& key, unsigned int hashValue) const
 {
-    unsigned int hash_key = getBucketNumber(key);
-    Node* temp = m_hashTable[hash_key];
-    while (temp != nullptr) {
-        if (temp->m_key == key) {
-            return &(temp->m_value);
+    unsigned int slot = getBucketNumber(hashValue);
+    int probeLength = 1;
+    while (m_probeLengths[slot] >= probeLength) { //an item closer to home than we are means the key is absent
+        if (m_probeLengths[slot] == probeLength && m_slots[slot].m_key == key) {
+            return &(m_slots[slot].m_value);
         }
-        temp = temp->m_next;
+        slot = getBucketNumber(slot + 1);
+        probeLength++;
     }
     return nullptr;
 }
 
-template <class KeyType, class ValueType>
-int MyHash<KeyType, ValueType>::getNumItems() const
+template <class KeyType, class ValueType, class Allocator>
+int MyHash<KeyType, ValueType, Allocator>::getNumItems() const
 {
     return m_items;
 }
 
-template <class KeyType, class ValueType>
-double MyHash<KeyType, ValueType>::getLoadFactor() const
+template <class KeyType, class ValueType, class Allocator>
+double MyHash<KeyType, ValueType, Allocator>::getLoadFactor() const
 {
     return m_currentLoadFactor;
 }
 
 //Private Methods Implementation
-template <class KeyType, class ValueType>
-unsigned int MyHash<KeyType, ValueType>::getBucketNumber(const KeyType& key) const
+template <class KeyType, class ValueType, class Allocator>
+unsigned int MyHash<KeyType, ValueType, Allocator>::getBucketNumber(unsigned int hashValue) const
 {
-    unsigned int hash(const KeyType& k);  //prototype
-    unsigned int slot = hash(key);
-    return slot % m_buckets;  //make provided hash values applicable
+    return hashValue & (m_buckets - 1);  //make provided hash values applicable; also wraps a probe past the last bucket
 }
 
-template <class KeyType, class ValueType>
-void MyHash<KeyType, ValueType>::clear()
+template <class KeyType, class ValueType, class Allocator>
+void MyHash<KeyType, ValueType, Allocator>::allocate(int buckets)
 {
-    for (int i = 0; i < m_buckets; i++) { //deallocate each bucket
-        Node* begin = m_hashTable[i];
-        while (begin != nullptr) {
-            Node* killMe = begin;
-            begin = begin->m_next;
-            delete killMe;
-        }
+    m_buckets = buckets;
+    m_items = 0;
+    m_currentLoadFactor = 0.0;
+    m_slots = m_allocator.template allocate<Slot>(m_buckets);
+    m_probeLengths = m_allocator.template allocate<unsigned char>(m_buckets);
+    for (int i = 0; i < m_buckets; i++) {
+        m_probeLengths[i] = 0;
     }
-    delete [] m_hashTable; //deallocate whole dynamic array
 }
 
-template <class KeyType, class ValueType>
-void MyHash<KeyType, ValueType>::reHash()
+template <class KeyType, class ValueType, class Allocator>
+void MyHash<KeyType, ValueType, Allocator>::clear()
 {
-    int previousSize = m_buckets; //save the size of the old array
-    m_buckets *= 2;
-    Node** newHashTable = new Node* [m_buckets];
-    for (int i = 0; i < m_buckets; i++) {
-        newHashTable[i] = nullptr;
+    release(m_slots, m_buckets); //items live in the table itself, so one deallocation releases all of them
+    release(m_probeLengths, m_buckets);
+    m_slots = nullptr;
+    m_probeLengths = nullptr;
+}
+
+template <class KeyType, class ValueType, class Allocator>
+void MyHash<KeyType, ValueType, Allocator>::place(Slot& item, unsigned int slot, int probeLength)
+{
+    for (;;) {
+        if (probeLength > MAX_HASH_PROBE_LENGTH) { //too far from home to record: a doubled table spreads the items out
+            unsigned int hash(const KeyType& k);  //prototype
+            Slot carried = std::move(item);
+            reHash();
+            place(carried, getBucketNumber(hash(carried.m_key)), 1);
+            return;
+        }
+        if (m_probeLengths[slot] == 0) {
+            m_slots[slot] = std::move(item);
+            m_probeLengths[slot] = probeLength;
+            return;
+        }
+        if (m_probeLengths[slot] < probeLength) { //resident is closer to home than us: take its slot and carry it onward
+            std::swap(m_slots[slot], item);
+            int resident = m_probeLengths[slot];
+            m_probeLengths[slot] = probeLength;
+            probeLength = resident;
+        }
+        slot = getBucketNumber(slot + 1);
+        probeLength++;
     }
-    for (int i = 0; i < previousSize; i++) { //copy over elements of old array into new array.
-        Node* p = m_hashTable[i];
-        while (p != nullptr) {
-            unsigned int newSlot = getBucketNumber(p->m_key); //NOTE: Elements of old array will unlikely not be assigned to the same bucket in the new array since the new array is bigger. Also, elements belonging to the same bucket may not be grouped together in new array once again because the size of the array has changed.
-            Node* newNode = new Node();
-            newNode->m_key = p->m_key;
-            newNode->m_value = p->m_value;
-            newNode->m_next = nullptr;
-            if (newHashTable[newSlot] == nullptr) {
-                newHashTable[newSlot] = newNode;
-            }
-            else{
-                Node* q = newHashTable[newSlot];
-                while (q->m_next != nullptr) {
-                    q = q->m_next;
-                }
-                q->m_next = newNode;
-            }
-            p = p->m_next;
+}
+
+template <class KeyType, class ValueType, class Allocator>
+void MyHash<KeyType, ValueType, Allocator>::reHash()
+{
+    unsigned int hash(const KeyType& k);  //prototype
+    Slot* oldSlots = m_slots; //save the old table so its items can be moved over
+    unsigned char* oldProbeLengths = m_probeLengths;
+    int previousSize = m_buckets;
+    int items = m_items;
+    allocate(previousSize * 2);
+    for (int i = 0; i < previousSize; i++) { //move elements of old array into new array instead of copying them.
+        if (oldProbeLengths[i] != 0) {
+            place(oldSlots[i], getBucketNumber(hash(oldSlots[i].m_key)), 1);
         }
     }
-    //clear(); //delete contents of old array
-    //m_buckets *= 2; //update bucket size
-    m_currentLoadFactor /= 2.0; //update load factor
-    m_hashTable = newHashTable;
+    release(oldSlots, previousSize); //delete contents of old array
+    release(oldProbeLengths, previousSize);
+    m_items = items;
+    m_currentLoadFactor = double(m_items)/double(m_buckets); //update load factor
+}
+
+template <class KeyType, class ValueType, class Allocator>
+template <typename T>
+void MyHash<KeyType, ValueType, Allocator>::release(T* items, int n)
+{
+    if (Allocator::FREES_MEMORY || !std::is_trivially_destructible<T>::value) { //otherwise there is nothing to free and nothing to destroy
+        m_allocator.deallocate(items, n);
+    }
 }
 
 #endif /* MyHash_h */
@@ -0,0 +1,81 @@
+//
+//  Pattern.h
+//  Cracked
+//
+
+#ifndef Pattern_h
+#define Pattern_h
+
+#include <string_view>
+#include <cstdint>
+#include "Ascii.h"
+
+const int PATTERN_KEY_SYMBOLS = 24;  //pattern characters a PatternKey holds exactly
+
+//A word's letter pattern ("ABCCBA" for "ZYXXYZ") packed into two integers, built in one pass over the word with a
+//26-entry array on the stack. Each of the first PATTERN_KEY_SYMBOLS pattern characters takes 5 bits, 'A' + i as
+//i + 1 and an apostrophe as 27; the pattern's length takes the top 4 bits of each half. Words with the same pattern
+//always have the same key, and up to PATTERN_KEY_SYMBOLS characters long the converse holds too, so comparing
+//keys compares patterns. Longer patterns share a key with any pattern agreeing on the first characters and length.
+struct PatternKey{
+    uint64_t m_low;   //characters 0 to 11, then bits 0 to 3 of the length
+    uint64_t m_high;  //characters 12 to 23, then bits 4 to 7 of the length
+    int length() const
+    {
+        return int(m_low >> 60) | int(m_high >> 60) << 4;
+    }
+    bool exact() const  //the key alone identifies the pattern
+    {
+        return length() <= PATTERN_KEY_SYMBOLS;
+    }
+    bool operator==(const PatternKey& other) const
+    {
+        return m_low == other.m_low && m_high == other.m_high;
+    }
+};
+
+//the key of word's pattern, in either case; like the pattern, it skips characters other than letters and
+//apostrophes. word must have fewer than 256 letters and apostrophes.
+inline PatternKey patternKey(std::string_view word)
+{
+    unsigned char symbols[26] = {};  //pattern symbol assigned to each letter so far, 0 if not seen yet
+    unsigned char next = 1;
+    uint64_t halves[2] = {0, 0};
+    int length = 0;
+    for (char ch : word) {
+        uint64_t symbol;
+        unsigned char chClass = asciiClass(ch);
+        if (chClass == ASCII_LETTER) {
+            unsigned char& s = symbols[(ch & ~0x20) - 'A'];
+            if (s == 0) {
+                s = next++;
+            }
+            symbol = s;
+        }
+        else if (chClass == ASCII_APOSTROPHE) {
+            symbol = 27;
+        }
+        else {
+            continue;
+        }
+        if (length < PATTERN_KEY_SYMBOLS) {
+            halves[length / 12] |= symbol << (length % 12 * 5);
+        }
+        length++;
+    }
+    return {halves[0] | uint64_t(length & 15) << 60, halves[1] | uint64_t(length >> 4 & 15) << 60};
+}
+
+inline uint64_t mix(uint64_t x) //splitmix64 finalizer: spreads every input bit over the whole result
+{
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+inline uint32_t patternKeyHash(const PatternKey& key) //stable across builds, so it can be stored in snapshots
+{
+    return mix(key.m_low ^ mix(key.m_high));
+}
+
+#endif /* Pattern_h */
@@ -0,0 +1,266 @@
+//
+//  Protocol.h
+//  Cracked
+//
+
+#ifndef Protocol_h
+#define Protocol_h
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//The decrypter server's protocol, spoken over a Unix domain stream socket. Both sides send frames: a 4-byte
+//big-endian payload length, then the payload. A client sends a request frame and reads back one response frame,
+//as many times as it likes over one connection; the server answers each connection's requests in order.
+//  request:  deadline in ms (4 bytes, 0 for the server's default), most decryptions (4 bytes, 0 for no limit),
+//            flags (1 byte), then the ciphertext, which takes the rest of the payload
+//  response: status (1 byte), number of decryptions (4 bytes), then each decryption as a 4-byte length and its characters
+//Integers are unsigned and big-endian throughout.
+
+const uint32_t MAX_FRAME_LENGTH = 1 << 26;  //longer frames are refused rather than buffered
+
+const unsigned char REQUEST_RANKED = 1;  //flag: crack best first, so the likeliest decryptions come first
+
+const unsigned char RESPONSE_COMPLETE = 0;     //every decryption there is
+const unsigned char RESPONSE_STOPPED = 1;      //the deadline or the most decryptions was reached, or the rest didn't fit in a frame
+const unsigned char RESPONSE_BAD_REQUEST = 2;  //the request couldn't be parsed; no decryptions
+
+struct CrackRequest{
+    uint32_t m_deadlineMs = 0;
+    uint32_t m_maxResults = 0;
+    unsigned char m_flags = 0;
+    std::string m_ciphertext;
+};
+
+struct CrackResponse{
+    unsigned char m_status = RESPONSE_BAD_REQUEST;
+    std::vector<std::string> m_decryptions;
+};
+
+inline void putUint32(std::string& out, uint32_t n)
+{
+    char bytes[4] = {char(n >> 24), char(n >> 16), char(n >> 8), char(n)};
+    out.append(bytes, 4);
+}
+
+inline bool getUint32(std::string_view& in, uint32_t& n)  //consumes 4 bytes of in; false if it is too short
+{
+    if (in.length() < 4) {
+        return false;
+    }
+    const unsigned char* bytes = (const unsigned char*)in.data();
+    n = uint32_t(bytes[0]) << 24 | uint32_t(bytes[1]) << 16 | uint32_t(bytes[2]) << 8 | bytes[3];
+    in.remove_prefix(4);
+    return true;
+}
+
+inline std::string encodeRequest(const CrackRequest& request)
+{
+    std::string payload;
+    putUint32(payload, request.m_deadlineMs);
+    putUint32(payload, request.m_maxResults);
+    payload += char(request.m_flags);
+    payload += request.m_ciphertext;
+    return payload;
+}
+
+inline bool decodeRequest(std::string_view payload, CrackRequest& request)
+{
+    if (!getUint32(payload, request.m_deadlineMs) || !getUint32(payload, request.m_maxResults) || payload.empty()) {
+        return false;
+    }
+    request.m_flags = payload[0];
+    request.m_ciphertext.assign(payload.substr(1));
+    return true;
+}
+
+//Decryptions that would take the payload past MAX_FRAME_LENGTH are left out, and then the status says the
+//response stopped early.
+inline std::string encodeResponse(const CrackResponse& response)
+{
+    size_t length = 5;
+    uint32_t fit = 0;
+    while (fit < response.m_decryptions.size() && length + 4 + response.m_decryptions[fit].length() <= MAX_FRAME_LENGTH) {
+        length += 4 + response.m_decryptions[fit].length();
+        fit++;
+    }
+    std::string payload;
+    payload.reserve(length);
+    payload += char(fit < response.m_decryptions.size() ? RESPONSE_STOPPED : response.m_status);
+    putUint32(payload, fit);
+    for (uint32_t i = 0; i < fit; i++) {
+        putUint32(payload, response.m_decryptions[i].length());
+        payload += response.m_decryptions[i];
+    }
+    return payload;
+}
+
+inline bool decodeResponse(std::string_view payload, CrackResponse& response)
+{
+    uint32_t count;
+    if (payload.empty()) {
+        return false;
+    }
+    response.m_status = payload[0];
+    payload.remove_prefix(1);
+    if (!getUint32(payload, count)) {
+        return false;
+    }
+    response.m_decryptions.clear();
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t length;
+        if (!getUint32(payload, length) || payload.length() < length) {
+            return false;
+        }
+        response.m_decryptions.emplace_back(payload.substr(0, length));
+        payload.remove_prefix(length);
+    }
+    return payload.empty();
+}
+
+//Socket helpers. They retry reads and writes cut short by signals, and writes never raise SIGPIPE: a peer that
+//hung up just makes them return false. Linux has a send flag for that; macOS has a socket option instead, which
+//ignoreSigpipe sets on every socket these helpers make and the server accepts.
+
+#ifdef MSG_NOSIGNAL
+const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+const int SEND_FLAGS = 0;
+#endif
+
+inline void ignoreSigpipe(int fd)
+{
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+    (void)fd;
+#endif
+}
+
+inline bool writeAll(int fd, const char* data, size_t length)
+{
+    while (length > 0) {
+        ssize_t written = send(fd, data, length, SEND_FLAGS);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            return false;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+inline bool readAll(int fd, char* data, size_t length)
+{
+    while (length > 0) {
+        ssize_t got = recv(fd, data, length, 0);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {  //end of file, an error, or a receive timeout
+            return false;
+        }
+        data += got;
+        length -= got;
+    }
+    return true;
+}
+
+inline bool writeFrame(int fd, std::string_view payload)  //false if the payload is too long for readFrame, sending nothing
+{
+    if (payload.length() > MAX_FRAME_LENGTH) {
+        return false;
+    }
+    std::string frame;
+    frame.reserve(4 + payload.length());
+    putUint32(frame, payload.length());
+    frame += payload;
+    return writeAll(fd, frame.data(), frame.length());
+}
+
+inline bool readFrame(int fd, std::string& payload)  //false at the end of the connection, on an error, or on a frame too long
+{
+    char header[4];
+    uint32_t length;
+    if (!readAll(fd, header, 4)) {
+        return false;
+    }
+    std::string_view headerView(header, 4);
+    getUint32(headerView, length);
+    if (length > MAX_FRAME_LENGTH) {
+        return false;
+    }
+    payload.resize(length);
+    return readAll(fd, &payload[0], length);
+}
+
+//fills address with path; false if path is too long for a socket address
+inline bool unixAddress(const char* path, sockaddr_un& address)
+{
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if (strlen(path) >= sizeof(address.sun_path)) {
+        return false;
+    }
+    strcpy(address.sun_path, path);
+    return true;
+}
+
+inline int connectUnix(const char* path)  //a connected socket, or -1
+{
+    sockaddr_un address;
+    if (!unixAddress(path, address)) {
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    ignoreSigpipe(fd);
+    if (connect(fd, (const sockaddr*)&address, sizeof(address)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+//a listening socket bound to path, or -1; a socket already at path is replaced only if no server answers on it
+inline int listenUnix(const char* path, int backlog)
+{
+    sockaddr_un address;
+    if (!unixAddress(path, address)) {
+        return -1;
+    }
+    struct stat existing;
+    if (stat(path, &existing) == 0 && S_ISSOCK(existing.st_mode)) {
+        int live = connectUnix(path);
+        if (live >= 0) {
+            close(live);
+            return -1;
+        }
+        unlink(path); //left behind by a server that didn't shut down cleanly
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (bind(fd, (const sockaddr*)&address, sizeof(address)) < 0 || listen(fd, backlog) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+#endif /* Protocol_h */
@@ -0,0 +1,117 @@
+//
+//  ThreadPool.h
+//  Cracked
+//
+
+#ifndef ThreadPool_h
+#define ThreadPool_h
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
+#include <vector>
+
+//Runs work(worker, task) once for every task, using threadCount threads (the calling thread is worker 0).
+//Each worker starts with its own share of the tasks and takes them from the back of its own deque; a worker
+//that runs out steals from the front of another worker's deque, so uneven tasks still keep every thread busy.
+template <typename Task, typename Work>
+void runWorkStealing(const std::vector<Task>& tasks, int threadCount, Work work)
+{
+    if (threadCount < 1) {
+        threadCount = 1;
+    }
+    struct WorkQueue{
+        std::mutex m_lock;
+        std::deque<const Task*> m_tasks;
+    };
+    std::vector<WorkQueue> queues(threadCount);
+    for (int i = 0; i < tasks.size(); i++) { //deal the tasks out round robin
+        queues[i % threadCount].m_tasks.push_back(&tasks[i]);
+    }
+    auto takeTask = [&queues, threadCount](int worker) -> const Task* {
+        {
+            std::lock_guard<std::mutex> guard(queues[worker].m_lock);
+            if (!queues[worker].m_tasks.empty()) {
+                const Task* task = queues[worker].m_tasks.back();
+                queues[worker].m_tasks.pop_back();
+                return task;
+            }
+        }
+        for (int i = 1; i < threadCount; i++) { //own deque is empty: steal from the others
+            WorkQueue& victim = queues[(worker + i) % threadCount];
+            std::lock_guard<std::mutex> guard(victim.m_lock);
+            if (!victim.m_tasks.empty()) {
+                const Task* task = victim.m_tasks.front();
+                victim.m_tasks.pop_front();
+                return task;
+            }
+        }
+        return nullptr; //no task is queued anywhere, and tasks never create new ones, so this worker is done
+    };
+    auto runWorker = [&takeTask, &work](int worker) {
+        const Task* task;
+        while ((task = takeTask(worker)) != nullptr) {
+            work(worker, *task);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (int worker = 1; worker < threadCount; worker++) {
+        threads.push_back(std::thread(runWorker, worker));
+    }
+    runWorker(0);
+    for (int i = 0; i < threads.size(); i++) {
+        threads[i].join();
+    }
+}
+
+//A first-in first-out queue shared by producer and consumer threads. push blocks while the queue holds capacity
+//items, so a fast producer can't run arbitrarily far ahead of its consumers, and pop blocks while it is empty.
+template <typename T>
+class BoundedQueue
+{
+public:
+    BoundedQueue(int capacity): m_capacity(capacity < 1 ? 1 : capacity), m_closed(false) {}
+    bool push(T item)  //false if the queue was closed, in which case item is dropped
+    {
+        std::unique_lock<std::mutex> guard(m_lock);
+        m_notFull.wait(guard, [this] { return m_items.size() < m_capacity || m_closed; });
+        if (m_closed) {
+            return false;
+        }
+        m_items.push_back(std::move(item));
+        m_notEmpty.notify_one();
+        return true;
+    }
+    bool pop(T& item)  //false once the queue is closed and every item pushed before that has been popped
+    {
+        std::unique_lock<std::mutex> guard(m_lock);
+        m_notEmpty.wait(guard, [this] { return !m_items.empty() || m_closed; });
+        if (m_items.empty()) {
+            return false;
+        }
+        item = std::move(m_items.front());
+        m_items.pop_front();
+        m_notFull.notify_one();
+        return true;
+    }
+    void close()  //no more pushes: wakes every waiting thread
+    {
+        std::lock_guard<std::mutex> guard(m_lock);
+        m_closed = true;
+        m_notFull.notify_all();
+        m_notEmpty.notify_all();
+    }
+      // We prevent a BoundedQueue object from being copied or assigned.
+    BoundedQueue(const BoundedQueue&) = delete;
+    BoundedQueue& operator=(const BoundedQueue&) = delete;
+private:
+    std::mutex m_lock;
+    std::condition_variable m_notFull;
+    std::condition_variable m_notEmpty;
+    std::deque<T> m_items;
+    int m_capacity;
+    bool m_closed;
+};
+
+#endif /* ThreadPool_h */
@@ -1,44 +1,49 @@
 #include "provided.h"
 #include <string>
+#include <string_view>
 #include <vector>
-#include <unordered_set>
 using namespace std;
 
 class TokenizerImpl
 {
 public:
-    TokenizerImpl(string separators);
+    TokenizerImpl(const CharacterSet& separators);
     vector<string> tokenize(const std::string& s) const;
+    void tokenize(string_view s, vector<string_view>& tokens) const;
 private:
-    unordered_set<char> m_separators; //unordered set is O(1) for insertions and searching
+    CharacterSet m_separators; //256-bit table: one lookup per character, no hashing
 };
 
-TokenizerImpl::TokenizerImpl(string separators)
+TokenizerImpl::TokenizerImpl(const CharacterSet& separators): m_separators(separators)
 {
-    for (int i = 0; i < separators.length(); i++) {
-        m_separators.insert(separators[i]); //convert each character in the string to a string
-    }
+    
 }
 
 vector<string> TokenizerImpl::tokenize(const std::string& s) const
 {
-    vector<string> tokenized;
-    string currentString = "";
+    vector<string_view> views;
+    tokenize(s, views);
+    return vector<string>(views.begin(), views.end());
+}
+
+void TokenizerImpl::tokenize(string_view s, vector<string_view>& tokens) const
+{
+    tokens.clear();
+    int start = -1; //where the current token starts, or -1 between tokens
     for (int i = 0; i < s.length(); i++) {
-        if (m_separators.find(s[i]) != m_separators.end()) {
-            if (!currentString.empty()) {
-                tokenized.push_back(currentString);
+        if (m_separators.contains(s[i])) {
+            if (start >= 0) {
+                tokens.push_back(s.substr(start, i - start));
             }
-            currentString = "";
+            start = -1;
         }
-        else{
-            currentString += s[i];
+        else if (start < 0) {
+            start = i;
         }
     }
-    if (!currentString.empty()){
-        tokenized.push_back(currentString);
+    if (start >= 0) {
+        tokens.push_back(s.substr(start));
     }
-    return tokenized;
 }
 
 //******************** Tokenizer functions ************************************
@@ -47,6 +52,11 @@ vector<string> TokenizerImpl::tokenize(const std::string& s) const
 // You probably don't want to change any of this code.
 
 Tokenizer::Tokenizer(string separators)
+{
+    m_impl = new TokenizerImpl(CharacterSet(separators));
+}
+
+Tokenizer::Tokenizer(const CharacterSet& separators)
 {
     m_impl = new TokenizerImpl(separators);
 }
@@ -60,3 +70,8 @@ vector<string> Tokenizer::tokenize(const std::string& s) const
 {
     return m_impl->tokenize(s);
 }
+
+void Tokenizer::tokenize(string_view s, vector<string_view>& tokens) const
+{
+    m_impl->tokenize(s, tokens);
+}
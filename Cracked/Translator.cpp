@@ -1,8 +1,9 @@
 #include "provided.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <cctype>
-#include <unordered_map>
+#include "Ascii.h"
 using namespace std;
 
 class TranslatorImpl
@@ -12,64 +13,46 @@ public:
     bool pushMapping(string ciphertext, string plaintext);
     bool popMapping();
     string getTranslation(const string& ciphertext) const;
+    bool canPushMapping(string_view ciphertext, string_view plaintext) const;
 private:
-    unordered_map<char, char> m_defaultMap;   //empty mapping table
-    unordered_map<char, char> m_currentMap;   //current mapping table
-    vector<unordered_map<char, char>> m_mapStack;  //stack of mappings
+    char m_forward[26];   //current mapping table: plaintext letter for each ciphertext letter, '?' if unknown
+    unsigned int m_usedPlain;  //bit i is set when plaintext letter 'A' + i is already mapped to by some ciphertext letter
+    vector<char> m_trail;  //ciphertext letters in the order they were bound
+    vector<int> m_frames;  //stack of mappings: size of m_trail when each mapping was pushed
     //helper functions
-    string removeApostrophes(string s) const;
-    bool containsNonLetter(string text) const;
-    bool inconsistentMapping(string s, string t) const;
-    bool inconsistentMapping(const unordered_map<char, char>& map, string s, string t) const;
+    bool inconsistentMapping(string_view s, string_view t) const;
+    void bind(char c, char p); //add c -> p to the tables if c is not bound yet
+    void undoTo(int trailSize); //unbind every letter bound after the trail was trailSize long
 };
 
 //Public Member Function Implementations
 TranslatorImpl::TranslatorImpl()
 {
     for (int i = 0; i < 26; i++) {
-        char c = i + 'A';
-        m_defaultMap.insert({c, '?'});
+        m_forward[i] = '?';
     }
-    m_currentMap = m_defaultMap;
+    m_usedPlain = 0;
 }
 
 bool TranslatorImpl::pushMapping(string ciphertext, string plaintext)
 {
-    ciphertext = removeApostrophes(ciphertext);
-    plaintext = removeApostrophes(plaintext);
-    if (ciphertext.length() != plaintext.length() || containsNonLetter(ciphertext) || containsNonLetter(plaintext) || inconsistentMapping(ciphertext, plaintext)) { //beforehand error checking
+    if (inconsistentMapping(ciphertext, plaintext)) { //beforehand error checking
         return false;
     }
-    unordered_map<char, char> newMap;
-    if (m_mapStack.empty()) {
-        for (int i = 0; i < ciphertext.length(); i++) {
-            newMap.insert({toupper(ciphertext[i]), toupper(plaintext[i])});
-        }
+    ciphertext.resize(removeApostrophes(ciphertext, &ciphertext[0])); //in place: both are copies already
+    plaintext.resize(removeApostrophes(plaintext, &plaintext[0]));
+    m_frames.push_back(m_trail.size());
+    for (int i = 0; i < ciphertext.length(); i++) { //only letters that are not bound yet cost anything
+        bind(toupper(ciphertext[i]), toupper(plaintext[i]));
     }
-    else{
-        newMap = m_mapStack[m_mapStack.size() - 1];
-        if (inconsistentMapping(newMap, ciphertext, plaintext)) {
-            return false;
-        }
-        for (int i = 0; i < ciphertext.length(); i++) {
-            newMap.insert({toupper(ciphertext[i]), toupper(plaintext[i])});
-        }
-    }
-    m_currentMap = newMap;
-    m_mapStack.push_back(newMap);
     return true;
 }
 
 bool TranslatorImpl::popMapping()
 {
-    if (!m_mapStack.empty()) {
-        m_mapStack.pop_back();
-        if (!m_mapStack.empty()) {
-            m_currentMap = m_mapStack[m_mapStack.size() - 1];
-        }
-        else{
-            m_currentMap = m_defaultMap;
-        }
+    if (!m_frames.empty()) {
+        undoTo(m_frames.back()); //undo exactly the letters the last push bound
+        m_frames.pop_back();
         return true;
     }
     return false;
@@ -77,96 +60,91 @@ bool TranslatorImpl::popMapping()
 
 string TranslatorImpl::getTranslation(const string& ciphertext) const
 {
-    string plaintext = "";
-    for (int i = 0; i < ciphertext.length(); i++) {
-        if (isalpha(ciphertext[i])) {
-            unordered_map<char, char>::const_iterator find = m_currentMap.find(toupper(ciphertext[i]));
-            if (find != m_currentMap.end()) {
-                if (islower(ciphertext[i])) {   //be careful of case sensitivity
-                    plaintext += tolower(find->second);
-                }
-                else{
-                    plaintext += find->second;
-                }
+    string plaintext(ciphertext);
+    for (int i = 0; i < plaintext.length(); i++) {
+        if (isalpha(plaintext[i])) {
+            char p = m_forward[toupper(plaintext[i]) - 'A'];
+            if (islower(plaintext[i]) && p != '?') {   //be careful of case sensitivity
+                plaintext[i] = tolower(p);
             }
             else{
-                plaintext += '?';
+                plaintext[i] = p;
             }
         }
-        else{
-            plaintext += ciphertext[i];
-        }
     }
     return plaintext;
 }
 
-//Private Methods
-string TranslatorImpl::removeApostrophes(string s) const
+bool TranslatorImpl::canPushMapping(string_view ciphertext, string_view plaintext) const
 {
-    string str = "";
-    for (int i = 0; i < s.length(); i++) {
-        if (s[i] != '\'') {
-            str += s[i];
-        }
-    }
-    return str;
+    return !inconsistentMapping(ciphertext, plaintext);
 }
 
-bool TranslatorImpl::containsNonLetter(string text) const
+//Private Methods
+bool TranslatorImpl::inconsistentMapping(string_view s, string_view t) const //true if s -> t is malformed, contradicts itself or contradicts the current mapping table
 {
-    for (int i = 0; i < text.length(); i++) {
-        if (!isalpha(text[i])) {
+    unsigned int usedPlain = m_usedPlain;  //plaintext letters taken, including by earlier letters of s
+    unsigned int newCipher = 0;  //ciphertext letters of s that are unbound in the table but already seen in s
+    char newPlain[26];  //what those letters map to. Only read when their bit in newCipher is set.
+    int i = 0;
+    int j = 0;
+    for (;;) {
+        while (i < s.length() && s[i] == '\'') { //apostrophes are ignored on both sides
+            i++;
+        }
+        while (j < t.length() && t[j] == '\'') {
+            j++;
+        }
+        if (i == s.length() || j == t.length()) {
+            return i != s.length() || j != t.length();  //different number of letters
+        }
+        if (!isalpha(s[i]) || !isalpha(t[j])) {
             return true;
         }
-    }
-    return false;
-}
-
-bool TranslatorImpl::inconsistentMapping(string s, string t) const //preprocess error checking
-{
-    unordered_map<char, char> map;
-    for (int i = 0; i < s.length(); i++) {  //check to see if 1 cipertext letter maps to 2 or more different plaintext letters
-        unordered_map<char, char>::iterator find = map.find(toupper(s[i]));
-        if (find != map.end()) {
-            if (find->second != toupper(t[i])) {
+        int c = toupper(s[i]) - 'A';
+        char p = toupper(t[j]);
+        unsigned int pBit = 1u << (p - 'A');
+        if (m_forward[c] != '?') {
+            if (m_forward[c] != p) {  //same ciphertext letter would map to 2 different plaintext letters
                 return true;
             }
         }
-        else{
-            map.insert({toupper(s[i]), toupper(t[i])});
-        }
-    }
-    map.clear();  //check the other way: if 2 or more ciphertext letters map to the same plaintext letter
-    for (int j = 0; j < t.length(); j++) {
-        unordered_map<char, char>::iterator find = map.find(toupper(t[j]));
-        if (find != map.end()) {
-            if (find->second != toupper(s[j])) {
+        else if (newCipher & (1u << c)) {
+            if (newPlain[c] != p) {
                 return true;
             }
         }
-        else{
-            map.insert({toupper(t[j]), toupper(s[j])});
+        else {
+            if (usedPlain & pBit) {  //2 ciphertext letters would map to the same plaintext letter
+                return true;
+            }
+            usedPlain |= pBit;
+            newCipher |= 1u << c;
+            newPlain[c] = p;
         }
+        i++;
+        j++;
     }
-    return false;
 }
 
-bool TranslatorImpl::inconsistentMapping(const unordered_map<char, char>& map, string s, string t) const//check to see if implied mapping based on s and t would conflict with a prior mapping in current map table
+void TranslatorImpl::bind(char c, char p)
 {
-    for (int i = 0; i < s.length(); i++) {  //check to see if same ciphertext letter map would map to 2 or or more different plaintext letters
-        unordered_map<char, char>::const_iterator find = map.find(toupper(s[i]));
-        if (find != map.end() && find->second != toupper(t[i])) {
-            return true;
-        }
+    char& plain = m_forward[c - 'A'];
+    if (plain == '?') {  //letters bound by an earlier mapping cost nothing
+        plain = p;
+        m_usedPlain |= 1u << (p - 'A');
+        m_trail.push_back(c);
     }
-    for (int j = 0; j < t.length(); j++) { //check to see if adding the new mapping would cause 2 or more ciphertext letters to match to the same plain text letter
-        for (unordered_map<char, char>::const_iterator it = map.begin(); it != map.end(); it++) {
-            if (toupper(t[j]) == it->second && toupper(s[j]) != it->first) {
-                return true;
-            }
-        }
+}
+
+void TranslatorImpl::undoTo(int trailSize)
+{
+    while (m_trail.size() > trailSize) {
+        char& plain = m_forward[m_trail.back() - 'A'];
+        m_usedPlain &= ~(1u << (plain - 'A'));
+        plain = '?';
+        m_trail.pop_back();
     }
-    return false;
 }
 
 //******************** Translator functions ************************************
@@ -198,3 +176,8 @@ string Translator::getTranslation(const string& ciphertext) const
 {
     return m_impl->getTranslation(ciphertext);
 }
+
+bool Translator::canPushMapping(string_view ciphertext, string_view plaintext) const
+{
+    return m_impl->canPushMapping(ciphertext, plaintext);
+}
@@ -7,169 +7,896 @@
 //
 #include "provided.h"
 #include <string>
+#include <string_view>
 #include <vector>
 #include <functional>
 #include "MyHash.h"
+#include "Ascii.h"
+#include "Pattern.h"
+#include "Arena.h"
 #include <iostream>
 #include <fstream>
-#include <cctype>
+#include <cstdint>
+#include <cstring>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 using namespace std;
 
+const int MAX_WORD_LENGTH = 64; //lookups normalize words into stack buffers of this size, so longer lines in the word list are ignored
+const string SNAPSHOT_EXTENSION = ".snapshot"; //loadWordList(f) looks for a compiled snapshot of f at f + SNAPSHOT_EXTENSION
+const char SNAPSHOT_MAGIC[8] = {'C', 'R', 'A', 'C', 'K', 'E', 'D', 'W'};
+const uint32_t SNAPSHOT_VERSION = 6;  //bump whenever the layout below changes
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;  //snapshots are only read on machines with the byte order that wrote them
+const uint32_t BITSET_MIN_WORDS = 64;  //patterns with fewer words than this are cheaper to scan than to filter with bitsets
+const uint32_t NO_BITSETS = 0xFFFFFFFF;
+const uint32_t MEMBERSHIP_BUCKET_SIZE = 4;  //average words per displacement bucket of the membership index
+const uint32_t MAX_DISPLACEMENT = 1 << 24;  //a bucket needing more tries than this means the keys can't be perfectly hashed
+
+//A loaded word list is one read-only image: a header, a table of letter patterns, a hash index over their PatternKeys,
+//positional letter bitsets, a membership index, optional word frequencies, and an arena holding the pattern strings and the words. Each word
+//is stored once, as a length byte followed by its letters; words sharing a pattern sit back to back in word list
+//order. Each pattern with many words also has one bitset over its words for every (position, letter) pair, so the
+//words fitting a partial translation like "?H?" are found by ANDing a few bitsets instead of comparing every word.
+//The membership index is a minimal perfect hash (hash and displace) over the distinct words: a word's hash picks a
+//bucket, the bucket's displacement picks exactly one slot, and the slot holds the only word that can be equal to it,
+//so contains is one hash and one comparison. A word list with a frequency column also gets the log frequency of
+//each distinct word, stored by its membership slot, or if the words couldn't be perfectly hashed, of every word in
+//arena order, found by scanning its pattern like contains does. The image is the same whether it was just built from the text file or
+//mapped straight from a snapshot file, so a snapshot is ready to serve lookups with no parsing.
+struct SnapshotHeader{
+    char m_magic[8];
+    uint32_t m_version;
+    uint32_t m_byteOrder;
+    uint64_t m_sourceSize;  //size and modification time of the text file the snapshot was compiled from
+    int64_t m_sourceModified;
+    uint64_t m_imageSize;
+    uint32_t m_patternCount;
+    uint32_t m_indexSize;  //number of index slots, a power of 2
+    uint64_t m_patternsOffset;  //byte offsets of each section from the start of the image
+    uint64_t m_indexOffset;
+    uint64_t m_bitsetsOffset;
+    uint64_t m_bitsetsSize;  //in 64-bit words
+    uint32_t m_memberCount;  //distinct words in the membership index, 0 if the words couldn't be perfectly hashed
+    uint32_t m_memberBucketCount;
+    uint64_t m_displacementsOffset;  //m_memberBucketCount displacements
+    uint64_t m_membersOffset;  //m_memberCount arena offsets of words
+    uint32_t m_frequencyCount;  //0 if the word list had no frequency column, else m_memberCount, or m_wordCount if that is 0
+    uint32_t m_wordCount;  //words in the arena, a word listed twice counting twice
+    uint64_t m_frequenciesOffset;  //m_frequencyCount log frequencies, one per membership slot or else one per word
+    uint64_t m_arenaOffset;
+    uint64_t m_arenaSize;
+};
+
+struct SnapshotPattern{
+    PatternKey m_key;  //what the index compares; the pattern string is only compared when the key isn't exact
+    uint32_t m_patternOffset;  //offset of the pattern string in the arena
+    uint32_t m_wordsOffset;  //offset of the first word's length byte in the arena
+    uint32_t m_wordCount;
+    uint32_t m_length;  //length of the pattern and of every word with it
+    //first 64-bit word of this pattern's bitsets, or NO_BITSETS. The bitset of words with letter 'A' + c at
+    //position j is the ceil(m_wordCount / 64) words starting (j * 26 + c) * ceil(m_wordCount / 64) words later.
+    uint32_t m_bitsets;
+    uint32_t m_firstWord;  //how many words come before this pattern's in the arena
+};
+
 class WordListImpl
 {
 public:
+    WordListImpl();
+    ~WordListImpl();
     bool loadWordList(string filename);
-    bool contains(string word) const;
-    vector<string> findCandidates(string cipherWord, string currTranslation) const;
+    bool saveSnapshot() const;
+    bool contains(string_view word) const;
+    vector<string> findCandidates(string_view cipherWord, string_view currTranslation) const;
+    int countCandidates(string_view cipherWord, string_view currTranslation) const;
+    bool hasCandidates(string_view cipherWord, string_view currTranslation) const;
+    double logFrequency(string_view word) const;
+    int candidateLetters(string_view cipherWord, string_view currTranslation, const unsigned int* allowed, unsigned int* support) const;
 private:
-    MyHash<string, vector<string>> m_wordList;
+    vector<uint64_t> m_built;  //image built from a text file (64-bit elements keep it aligned)
+    void* m_mapped;  //image mapped from a snapshot file
+    size_t m_mappedSize;
+    string m_snapshotFilename;  //where the loaded text file's snapshot belongs, empty if it was loaded from one
+    //the image in use, with pointers to its sections
+    const SnapshotHeader* m_header;
+    const SnapshotPattern* m_patterns;
+    const uint32_t* m_index;  //pattern number + 1 for each slot, 0 if the slot is empty
+    const uint64_t* m_bitsets;
+    const uint32_t* m_displacements;
+    const uint32_t* m_members;
+    const float* m_frequencies;
+    const char* m_arena;
+    void unload();
+    bool loadSnapshot(const string& filename, const struct stat* source);
+    bool loadText(const string& filename, const struct stat* source);
+    bool useImage(const char* image, size_t size); //checks that the image is intact before serving lookups from it
+    const SnapshotPattern* findPattern(string_view upperWord) const;  //the entry for upperWord's pattern, or nullptr
+    int findMember(string_view upperWord) const;  //the membership slot holding upperWord, or -1
+    struct MembershipKey{
+        uint64_t m_hash;
+        uint32_t m_offset;  //where the word will be in the arena
+        string_view m_word;
+    };
+    bool buildMembershipIndex(vector<MembershipKey>& keys, uint32_t bucketCount, vector<uint32_t>& displacements, vector<uint32_t>& members) const;
+    //the pattern whose words can be candidates, or nullptr if there are none; leaves currTranslation in capitals in CURRTRANSLATION
+    const SnapshotPattern* candidatePattern(string_view cipherWord, string_view currTranslation, char* CURRTRANSLATION) const;
+    int matchCandidates(string_view cipherWord, string_view currTranslation, vector<string>* candidates, int limit) const; //counts the candidates up to limit, also returning them if candidates isn't nullptr
     //private helper functions
     bool shouldIgnore(string file) const;
-    string allCaps(string s) const;
-    string generateWordPattern(string s) const;
-    bool invalidCipherWord(string s) const;
-    bool invalidCurrTranslation(string s) const;
-    bool invalidCorrespondingCharacters(string s, string t) const;
+    bool parseLine(const string& line, string& word, double& frequency) const;  //false for a malformed frequency; frequency is -1 if there is none
+    void allCaps(string_view s, char* buffer) const; //buffer must hold s.length() characters
+    int generateWordPattern(string_view s, char* buffer) const; //returns the pattern length
+    bool invalidCipherWord(string_view s) const;
+    bool invalidCurrTranslation(string_view s) const;
+    bool invalidCorrespondingCharacters(string_view s, string_view t) const;
 };
 
+uint64_t wordHash(string_view word) //64-bit FNV-1a, mixed: the high half picks a membership bucket, all of it feeds memberSlot
+{
+    uint64_t h = 14695981039346656037ull;
+    for (int i = 0; i < word.length(); i++) {
+        h = (h ^ (unsigned char)word[i]) * 1099511628211ull;
+    }
+    return mix(h);
+}
+
+uint32_t memberBucket(uint64_t hash, uint32_t bucketCount)
+{
+    return (hash >> 32) % bucketCount;
+}
+
+uint32_t memberSlot(uint64_t hash, uint32_t displacement, uint32_t memberCount)
+{
+    return mix(hash + displacement * 0x9E3779B97F4A7C15ull) % memberCount;
+}
+
 //Public Member Functions
-bool WordListImpl::loadWordList(string filename) //group words in file by letter pattern
+WordListImpl::WordListImpl(): m_mapped(nullptr), m_mappedSize(0), m_header(nullptr)
+{
+    
+}
+
+WordListImpl::~WordListImpl()
+{
+    unload();
+}
+
+bool WordListImpl::loadWordList(string filename)
+{
+    unload(); //start fresh
+    struct stat source;
+    bool haveSource = stat(filename.c_str(), &source) == 0;
+    if (loadSnapshot(filename + SNAPSHOT_EXTENSION, haveSource ? &source : nullptr)) {
+        return true;
+    }
+    if (!haveSource) {  //failed to open file
+        cerr << "Error! Cannot open " << filename << endl;
+        return false;
+    }
+    return loadText(filename, &source);
+}
+
+bool WordListImpl::saveSnapshot() const //compile step: write the image next to the text file it was built from
+{
+    if (m_header == nullptr || m_snapshotFilename.empty()) {
+        return m_header != nullptr; //loaded from an up to date snapshot already
+    }
+    string temporary = m_snapshotFilename + ".tmp";
+    ofstream outfile(temporary, ios::binary);
+    if (!outfile) {
+        cerr << "Error! Cannot write " << temporary << endl;
+        return false;
+    }
+    outfile.write(reinterpret_cast<const char*>(m_header), m_header->m_imageSize);
+    outfile.close();
+    if (!outfile || rename(temporary.c_str(), m_snapshotFilename.c_str()) != 0) { //readers never see a half written snapshot
+        cerr << "Error! Cannot write " << m_snapshotFilename << endl;
+        remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool WordListImpl::contains(string_view word) const //never touches the heap: the word and its pattern are built on the stack
+{
+    if (word.length() > MAX_WORD_LENGTH) {
+        return false;  //longer than anything loaded
+    }
+    char WORD[MAX_WORD_LENGTH];
+    allCaps(word, WORD);  //case insensitivty
+    string_view upperWord(WORD, word.length());
+    if (m_header != nullptr && m_header->m_memberCount != 0) {
+        return findMember(upperWord) != -1;
+    }
+    const SnapshotPattern* words = findPattern(upperWord);
+    if (words != nullptr && words->m_length == word.length()) {
+        const char* list = m_arena + words->m_wordsOffset;
+        for (int i = 0; i < words->m_wordCount; i++) {
+            if (memcmp(list + i * (words->m_length + 1) + 1, WORD, words->m_length) == 0) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+vector<string> WordListImpl::findCandidates(string_view cipherWord, string_view currTranslation) const
+{
+    vector<string> candidates;
+    matchCandidates(cipherWord, currTranslation, &candidates, INT_MAX);
+    return candidates;
+}
+
+int WordListImpl::countCandidates(string_view cipherWord, string_view currTranslation) const //same as findCandidates(...).size(), without building any strings
+{
+    return matchCandidates(cipherWord, currTranslation, nullptr, INT_MAX);
+}
+
+bool WordListImpl::hasCandidates(string_view cipherWord, string_view currTranslation) const //stops at the first candidate
+{
+    return matchCandidates(cipherWord, currTranslation, nullptr, 1) != 0;
+}
+
+double WordListImpl::logFrequency(string_view word) const
+{
+    if (m_header == nullptr || m_header->m_frequencyCount == 0) {
+        return 0;  //no frequency column: every word is as likely as any other
+    }
+    if (word.length() > MAX_WORD_LENGTH) {
+        return -HUGE_VAL;
+    }
+    char WORD[MAX_WORD_LENGTH];
+    allCaps(word, WORD);
+    string_view upperWord(WORD, word.length());
+    if (m_header->m_memberCount != 0) {
+        int slot = findMember(upperWord);
+        return slot == -1 ? -HUGE_VAL : m_frequencies[slot];
+    }
+    const SnapshotPattern* words = findPattern(upperWord); //no perfect hash: frequencies are stored per word
+    if (words != nullptr && words->m_length == word.length()) {
+        const char* list = m_arena + words->m_wordsOffset;
+        for (int i = 0; i < words->m_wordCount; i++) {
+            if (memcmp(list + i * (words->m_length + 1) + 1, WORD, words->m_length) == 0) {
+                return m_frequencies[words->m_firstWord + i];
+            }
+        }
+    }
+    return -HUGE_VAL;
+}
+
+int WordListImpl::candidateLetters(string_view cipherWord, string_view currTranslation, const unsigned int* allowed, unsigned int* support) const
+{
+    for (int j = 0; j < cipherWord.length(); j++) {
+        support[j] = 0;
+    }
+    char CURRTRANSLATION[MAX_WORD_LENGTH];
+    const SnapshotPattern* words = candidatePattern(cipherWord, currTranslation, CURRTRANSLATION);
+    if (words == nullptr) {
+        return 0;
+    }
+    const char* list = m_arena + words->m_wordsOffset;
+    int count = 0;
+    if (words->m_bitsets == NO_BITSETS) {
+        for (int i = 0; i < words->m_wordCount; i++) {
+            const char* word = list + i * (words->m_length + 1) + 1;
+            bool fits = true;
+            for (int j = 0; j < words->m_length && fits; j++) {
+                if (isLetter(CURRTRANSLATION[j])) {
+                    fits = CURRTRANSLATION[j] == word[j];
+                }
+                else if (CURRTRANSLATION[j] == '?') {
+                    fits = isLetter(word[j]) && (allowed[j] & (1u << (word[j] - 'A')));
+                }
+                else {
+                    fits = word[j] == '\'';
+                }
+            }
+            if (fits) {
+                count++;
+                for (int j = 0; j < words->m_length; j++) {
+                    if (isLetter(word[j])) {
+                        support[j] |= 1u << (word[j] - 'A');
+                    }
+                }
+            }
+        }
+        return count;
+    }
+    //The words that fit are the words with every known letter, and at every unknown position one of its allowed
+    //letters; a letter is supported at a position when its bitset there shares a word with them.
+    int blocks = (words->m_wordCount + 63) / 64;
+    const uint64_t* known[MAX_WORD_LENGTH];
+    int knownCount = 0;
+    int unknown[MAX_WORD_LENGTH];
+    int unknownCount = 0;
+    for (int j = 0; j < words->m_length; j++) {
+        if (isLetter(CURRTRANSLATION[j])) {
+            known[knownCount++] = m_bitsets + words->m_bitsets + (j * 26 + (CURRTRANSLATION[j] - 'A')) * blocks;
+        }
+        else if (CURRTRANSLATION[j] == '?') {
+            unknown[unknownCount++] = j;
+        }
+    }
+    unsigned int supported[MAX_WORD_LENGTH] = {};
+    for (int b = 0; b < blocks; b++) {
+        uint64_t matches = ~uint64_t(0);
+        if (b == blocks - 1 && words->m_wordCount % 64 != 0) {
+            matches = (uint64_t(1) << (words->m_wordCount % 64)) - 1;
+        }
+        for (int k = 0; k < knownCount && matches != 0; k++) {
+            matches &= known[k][b];
+        }
+        for (int k = 0; k < unknownCount && matches != 0; k++) {
+            const uint64_t* letters = m_bitsets + words->m_bitsets + unknown[k] * 26 * blocks + b;
+            uint64_t fitting = 0;
+            for (unsigned int allow = allowed[unknown[k]] & ((1u << 26) - 1); allow != 0; allow &= allow - 1) {
+                fitting |= letters[__builtin_ctz(allow) * blocks];
+            }
+            matches &= fitting;
+        }
+        if (matches == 0) {
+            continue;
+        }
+        count += __builtin_popcountll(matches);
+        for (int k = 0; k < unknownCount; k++) {
+            const uint64_t* letters = m_bitsets + words->m_bitsets + unknown[k] * 26 * blocks + b;
+            for (unsigned int allow = allowed[unknown[k]] & ~supported[k] & ((1u << 26) - 1); allow != 0; allow &= allow - 1) {
+                int c = __builtin_ctz(allow);
+                if (letters[c * blocks] & matches) {
+                    supported[k] |= 1u << c;
+                }
+            }
+        }
+    }
+    for (int k = 0; k < unknownCount; k++) {
+        support[unknown[k]] = supported[k];
+    }
+    for (int j = 0; j < words->m_length && count != 0; j++) { //a known letter is supported only if some word fits, as in the scan
+        if (isLetter(CURRTRANSLATION[j])) {
+            support[j] = 1u << (CURRTRANSLATION[j] - 'A');
+        }
+    }
+    return count;
+}
+
+//Loading
+void WordListImpl::unload()
+{
+    if (m_mapped != nullptr) {
+        munmap(m_mapped, m_mappedSize);
+    }
+    m_mapped = nullptr;
+    m_mappedSize = 0;
+    m_built.clear();
+    m_built.shrink_to_fit();
+    m_snapshotFilename.clear();
+    m_header = nullptr;
+}
+
+bool WordListImpl::loadSnapshot(const string& filename, const struct stat* source)
+{
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;  //no snapshot compiled yet
+    }
+    struct stat snapshot;
+    void* mapped = MAP_FAILED;
+    if (fstat(fd, &snapshot) == 0 && snapshot.st_size >= sizeof(SnapshotHeader)) {
+        mapped = mmap(nullptr, snapshot.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close(fd);  //the mapping stays valid without the descriptor
+    if (mapped == MAP_FAILED) {
+        return false;
+    }
+    const SnapshotHeader* header = static_cast<const SnapshotHeader*>(mapped);
+    bool stale = source != nullptr && (header->m_sourceSize != source->st_size || header->m_sourceModified != source->st_mtime);
+    if (stale || !useImage(static_cast<const char*>(mapped), snapshot.st_size)) { //fall back to the text file
+        munmap(mapped, snapshot.st_size);
+        m_header = nullptr;
+        return false;
+    }
+    m_mapped = mapped;
+    m_mappedSize = snapshot.st_size;
+    return true;
+}
+
+bool WordListImpl::loadText(const string& filename, const struct stat* source) //group words in file by letter pattern
 {
-    m_wordList.reset(); //start fresh
     ifstream infile(filename);
     if (!infile) {  //failed to open file
         cerr << "Error! Cannot open " << filename << endl;
         return false;
     }
+    Arena scratch;  //the words, patterns and hash tables used while loading, freed together when loading is done
+    struct PatternGroup{ //the words with one pattern
+        PatternKey m_key;
+        string_view m_pattern;
+        int m_wordCount;
+        int m_firstWord;  //where the group's words start in byGroup, once they are sorted into it
+        int m_nextWithKey;  //another group whose pattern has the same key, or -1; only long patterns share keys
+    };
+    struct LoadedWord{
+        string_view m_word;
+        int m_group;
+    };
+    vector<PatternGroup> groups;  //in the order their patterns first appear
+    vector<LoadedWord> loaded;  //in word list order
+    MyHash<PatternKey, int, ArenaAllocator> firstGroup(0.5, ArenaAllocator(scratch));  //the last group created with each key
+    MyHash<string_view, double, ArenaAllocator> counts(0.5, ArenaAllocator(scratch));  //frequency column summed over each word's lines
+    double totalCount = 0;
+    uint64_t arenaSize = 0;
     string s;
-    while (getline(infile, s)) {  //load the data by adding it to MyHash member
-        if (!shouldIgnore(s)) {
-            string S = allCaps(s);   //case insensitivity
-            string pattern = generateWordPattern(S);
-            vector<string>* words = m_wordList.find(pattern);
-            if (words == nullptr) {   //new pattern
-                m_wordList.associate(pattern, vector<string>(1, S));
+    string word;
+    double frequency;
+    char WORD[MAX_WORD_LENGTH];
+    char pattern[MAX_WORD_LENGTH];
+    while (getline(infile, s)) {  //group the words with MyHash before laying them out in the image
+        if (parseLine(s, word, frequency) && !shouldIgnore(word)) {
+            allCaps(word, WORD);   //case insensitivity
+            string_view S = scratch.copy(string_view(WORD, word.length()));
+            if (frequency >= 0) {
+                double* count = counts.find(S);
+                if (count == nullptr) {
+                    counts.associate(S, frequency);
+                }
+                else {
+                    *count += frequency;
+                }
+                totalCount += frequency;
+            }
+            PatternKey key = patternKey(S);
+            int* first = firstGroup.find(key);
+            int g = first == nullptr ? -1 : *first;
+            if (g != -1 && !key.exact()) {
+                string_view wordPattern(pattern, generateWordPattern(S, pattern));
+                while (g != -1 && groups[g].m_pattern != wordPattern) {
+                    g = groups[g].m_nextWithKey;
+                }
             }
-            else{
-                words->push_back(S);   //pattern already exists
+            if (g == -1) {   //new pattern
+                g = groups.size();
+                groups.push_back({key, scratch.copy(string_view(pattern, generateWordPattern(S, pattern))), 0, 0, first == nullptr ? -1 : *first});
+                if (first == nullptr) {
+                    firstGroup.associate(key, g);
+                }
+                else {
+                    *first = g;
+                }
+                arenaSize += groups[g].m_pattern.length();
+            }
+            groups[g].m_wordCount++;
+            loaded.push_back({S, g});
+            arenaSize += S.length() + 1;
+        }
+    }
+    vector<string_view> byGroup(loaded.size());  //each group's words together, still in word list order
+    int start = 0;
+    for (int p = 0; p < groups.size(); p++) {
+        groups[p].m_firstWord = start;
+        start += groups[p].m_wordCount;
+        groups[p].m_wordCount = 0;
+    }
+    for (int i = 0; i < loaded.size(); i++) {
+        PatternGroup& group = groups[loaded[i].m_group];
+        byGroup[group.m_firstWord + group.m_wordCount++] = loaded[i].m_word;
+    }
+    uint32_t indexSize = 16;
+    while (indexSize < 2 * groups.size()) { //keep the index at most half full
+        indexSize *= 2;
+    }
+    uint64_t bitsetsSize = 0;
+    vector<MembershipKey> keys;
+    keys.reserve(loaded.size());
+    uint32_t offset = 0;
+    for (int p = 0; p < groups.size(); p++) { //work out where every word will go in the arena
+        const string_view* words = &byGroup[groups[p].m_firstWord];
+        int wordCount = groups[p].m_wordCount;
+        if (wordCount >= BITSET_MIN_WORDS) {
+            bitsetsSize += groups[p].m_pattern.length() * 26 * ((wordCount + 63) / 64);
+        }
+        offset += groups[p].m_pattern.length();
+        for (int i = 0; i < wordCount; i++) {
+            keys.push_back({wordHash(words[i]), offset, words[i]});
+            offset += words[i].length() + 1;
+        }
+    }
+    uint32_t bucketCount = keys.size() / MEMBERSHIP_BUCKET_SIZE + 1;
+    vector<uint32_t> displacements;
+    vector<uint32_t> members;
+    if (!buildMembershipIndex(keys, bucketCount, displacements, members)) { //contains and logFrequency fall back to scanning the word's pattern
+        cerr << "Warning! The words of " << filename << " couldn't be perfectly hashed, so looking them up is slower" << endl;
+        displacements.clear();
+        members.clear();
+    }
+    vector<float> frequencies;
+    if (counts.getNumItems() != 0 && !members.empty()) { //add one to every count, so words without one are merely rare
+        frequencies.resize(members.size());
+        for (int i = 0; i < keys.size(); i++) {
+            const double* count = counts.find(keys[i].m_word);
+            uint32_t slot = memberSlot(keys[i].m_hash, displacements[memberBucket(keys[i].m_hash, bucketCount)], members.size());
+            frequencies[slot] = log(((count == nullptr ? 0 : *count) + 1) / (totalCount + members.size()));
+        }
+    }
+    else if (counts.getNumItems() != 0) { //one frequency per word in arena order, with words counted once as above
+        int distinct = 0;
+        for (int p = 0; p < groups.size(); p++) {
+            vector<string_view> words(&byGroup[groups[p].m_firstWord], &byGroup[groups[p].m_firstWord] + groups[p].m_wordCount);
+            sort(words.begin(), words.end());
+            distinct += unique(words.begin(), words.end()) - words.begin();
+        }
+        for (int i = 0; i < byGroup.size(); i++) {
+            const double* count = counts.find(byGroup[i]);
+            frequencies.push_back(log(((count == nullptr ? 0 : *count) + 1) / (totalCount + distinct)));
+        }
+    }
+    SnapshotHeader header = {};
+    memcpy(header.m_magic, SNAPSHOT_MAGIC, sizeof(header.m_magic));
+    header.m_version = SNAPSHOT_VERSION;
+    header.m_byteOrder = SNAPSHOT_BYTE_ORDER;
+    header.m_sourceSize = source->st_size;
+    header.m_sourceModified = source->st_mtime;
+    header.m_patternCount = groups.size();
+    header.m_indexSize = indexSize;
+    header.m_patternsOffset = sizeof(SnapshotHeader);
+    header.m_indexOffset = header.m_patternsOffset + groups.size() * sizeof(SnapshotPattern);
+    header.m_bitsetsOffset = (header.m_indexOffset + indexSize * sizeof(uint32_t) + 7) / 8 * 8;
+    header.m_bitsetsSize = bitsetsSize;
+    header.m_memberCount = members.size();
+    header.m_memberBucketCount = members.empty() ? 0 : bucketCount;
+    header.m_displacementsOffset = header.m_bitsetsOffset + bitsetsSize * sizeof(uint64_t);
+    header.m_membersOffset = header.m_displacementsOffset + displacements.size() * sizeof(uint32_t);
+    header.m_frequencyCount = frequencies.size();
+    header.m_wordCount = byGroup.size();
+    header.m_frequenciesOffset = header.m_membersOffset + members.size() * sizeof(uint32_t);
+    header.m_arenaOffset = header.m_frequenciesOffset + frequencies.size() * sizeof(float);
+    header.m_arenaSize = arenaSize;
+    header.m_imageSize = header.m_arenaOffset + arenaSize;
+    m_built.assign((header.m_imageSize + sizeof(uint64_t) - 1) / sizeof(uint64_t), 0);
+    char* image = reinterpret_cast<char*>(m_built.data());
+    memcpy(image, &header, sizeof(header));
+    SnapshotPattern* table = reinterpret_cast<SnapshotPattern*>(image + header.m_patternsOffset);
+    uint32_t* index = reinterpret_cast<uint32_t*>(image + header.m_indexOffset);
+    uint64_t* bitsets = reinterpret_cast<uint64_t*>(image + header.m_bitsetsOffset);
+    char* arena = image + header.m_arenaOffset;
+    memcpy(image + header.m_displacementsOffset, displacements.data(), displacements.size() * sizeof(uint32_t));
+    memcpy(image + header.m_membersOffset, members.data(), members.size() * sizeof(uint32_t));
+    memcpy(image + header.m_frequenciesOffset, frequencies.data(), frequencies.size() * sizeof(float));
+    offset = 0;
+    uint32_t bitsetsUsed = 0;
+    for (int p = 0; p < groups.size(); p++) {
+        const string_view* words = &byGroup[groups[p].m_firstWord];
+        int wordCount = groups[p].m_wordCount;
+        table[p].m_key = groups[p].m_key;
+        table[p].m_patternOffset = offset;
+        table[p].m_length = groups[p].m_pattern.length();
+        memcpy(arena + offset, groups[p].m_pattern.data(), groups[p].m_pattern.length());
+        offset += groups[p].m_pattern.length();
+        table[p].m_wordsOffset = offset;
+        table[p].m_wordCount = wordCount;
+        table[p].m_bitsets = NO_BITSETS;
+        table[p].m_firstWord = groups[p].m_firstWord;
+        int blocks = (wordCount + 63) / 64;
+        if (wordCount >= BITSET_MIN_WORDS) {
+            table[p].m_bitsets = bitsetsUsed;
+            bitsetsUsed += groups[p].m_pattern.length() * 26 * blocks;
+        }
+        for (int i = 0; i < wordCount; i++) {
+            arena[offset] = words[i].length();
+            memcpy(arena + offset + 1, words[i].data(), words[i].length());
+            offset += words[i].length() + 1;
+            for (int j = 0; table[p].m_bitsets != NO_BITSETS && j < words[i].length(); j++) {
+                if (isLetter(words[i][j])) {
+                    bitsets[table[p].m_bitsets + (j * 26 + (words[i][j] - 'A')) * blocks + i / 64] |= uint64_t(1) << (i % 64);
+                }
             }
         }
+        uint32_t slot = patternKeyHash(groups[p].m_key) & (indexSize - 1);
+        while (index[slot] != 0) {  //linear probing
+            slot = (slot + 1) & (indexSize - 1);
+        }
+        index[slot] = p + 1;
     }
+    useImage(image, header.m_imageSize);
+    m_snapshotFilename = filename + SNAPSHOT_EXTENSION;
     return true;
 }
 
-bool WordListImpl::contains(string word) const
+bool WordListImpl::useImage(const char* image, size_t size)
 {
-    string WORD = allCaps(word);  //case insensitivty
-    string pattern = generateWordPattern(WORD);
-    const vector<string>* words = m_wordList.find(pattern);
-    if (words != nullptr) {
-        const vector<string> list = *(words);
-        for (int i = 0; i < list.size(); i++) {
-            if (list[i] == WORD) {
-                return true;
+    const SnapshotHeader* header = reinterpret_cast<const SnapshotHeader*>(image);
+    if (size < sizeof(SnapshotHeader) || memcmp(header->m_magic, SNAPSHOT_MAGIC, sizeof(header->m_magic)) != 0 || header->m_version != SNAPSHOT_VERSION || header->m_byteOrder != SNAPSHOT_BYTE_ORDER || header->m_imageSize != size) {
+        return false;
+    }
+    if ((header->m_indexSize & (header->m_indexSize - 1)) != 0 || header->m_indexSize <= header->m_patternCount || header->m_patternsOffset != sizeof(SnapshotHeader) || header->m_indexOffset != header->m_patternsOffset + uint64_t(header->m_patternCount) * sizeof(SnapshotPattern) || header->m_bitsetsOffset != (header->m_indexOffset + uint64_t(header->m_indexSize) * sizeof(uint32_t) + 7) / 8 * 8 || header->m_displacementsOffset != header->m_bitsetsOffset + header->m_bitsetsSize * sizeof(uint64_t) || header->m_membersOffset != header->m_displacementsOffset + uint64_t(header->m_memberBucketCount) * sizeof(uint32_t) || header->m_frequenciesOffset != header->m_membersOffset + uint64_t(header->m_memberCount) * sizeof(uint32_t) || (header->m_frequencyCount != 0 && header->m_frequencyCount != (header->m_memberCount != 0 ? header->m_memberCount : header->m_wordCount)) || header->m_arenaOffset != header->m_frequenciesOffset + uint64_t(header->m_frequencyCount) * sizeof(float) || header->m_arenaOffset + header->m_arenaSize != size || (header->m_memberCount == 0) != (header->m_memberBucketCount == 0)) {
+        return false;
+    }
+    const SnapshotPattern* patterns = reinterpret_cast<const SnapshotPattern*>(image + header->m_patternsOffset);
+    const uint32_t* index = reinterpret_cast<const uint32_t*>(image + header->m_indexOffset);
+    for (int p = 0; p < header->m_patternCount; p++) { //a damaged snapshot must never make a lookup read outside the image
+        if (patterns[p].m_length > MAX_WORD_LENGTH || patterns[p].m_key.length() != patterns[p].m_length || patterns[p].m_patternOffset + uint64_t(patterns[p].m_length) > header->m_arenaSize || patterns[p].m_wordsOffset + uint64_t(patterns[p].m_wordCount) * (patterns[p].m_length + 1) > header->m_arenaSize) {
+            return false;
+        }
+        if (patterns[p].m_firstWord + uint64_t(patterns[p].m_wordCount) > header->m_wordCount) {
+            return false;
+        }
+        if (patterns[p].m_bitsets != NO_BITSETS && patterns[p].m_bitsets + uint64_t(patterns[p].m_length) * 26 * ((patterns[p].m_wordCount + 63) / 64) > header->m_bitsetsSize) {
+            return false;
+        }
+    }
+    uint32_t used = 0;
+    for (int slot = 0; slot < header->m_indexSize; slot++) {
+        if (index[slot] > header->m_patternCount) {
+            return false;
+        }
+        used += index[slot] != 0;
+    }
+    if (used != header->m_patternCount) { //one slot per pattern, so with the index bigger than that, every probe meets an empty slot and ends
+        return false;
+    }
+    const char* arena = image + header->m_arenaOffset;
+    const uint32_t* members = reinterpret_cast<const uint32_t*>(image + header->m_membersOffset);
+    for (int slot = 0; slot < header->m_memberCount; slot++) {
+        if (members[slot] >= header->m_arenaSize || members[slot] + 1 + uint64_t((unsigned char)arena[members[slot]]) > header->m_arenaSize) {
+            return false;
+        }
+    }
+    m_header = header;
+    m_patterns = patterns;
+    m_index = index;
+    m_bitsets = reinterpret_cast<const uint64_t*>(image + header->m_bitsetsOffset);
+    m_displacements = reinterpret_cast<const uint32_t*>(image + header->m_displacementsOffset);
+    m_members = members;
+    m_frequencies = reinterpret_cast<const float*>(image + header->m_frequenciesOffset);
+    m_arena = arena;
+    return true;
+}
+
+const SnapshotPattern* WordListImpl::findPattern(string_view upperWord) const
+{
+    if (m_header == nullptr) {
+        return nullptr;  //nothing loaded
+    }
+    PatternKey key = patternKey(upperWord);
+    char pattern[MAX_WORD_LENGTH];
+    int length = key.exact() ? 0 : generateWordPattern(upperWord, pattern); //only long patterns need their string
+    uint32_t mask = m_header->m_indexSize - 1;
+    for (uint32_t slot = patternKeyHash(key) & mask; m_index[slot] != 0; slot = (slot + 1) & mask) {
+        const SnapshotPattern& entry = m_patterns[m_index[slot] - 1];
+        if (entry.m_key == key && (key.exact() || memcmp(m_arena + entry.m_patternOffset, pattern, length) == 0)) {
+            return &entry;
+        }
+    }
+    return nullptr;
+}
+
+bool WordListImpl::buildMembershipIndex(vector<MembershipKey>& keys, uint32_t bucketCount, vector<uint32_t>& displacements, vector<uint32_t>& members) const
+{
+    sort(keys.begin(), keys.end(), [bucketCount](const MembershipKey& a, const MembershipKey& b) {
+        uint32_t bucketA = memberBucket(a.m_hash, bucketCount);
+        uint32_t bucketB = memberBucket(b.m_hash, bucketCount);
+        return bucketA != bucketB ? bucketA < bucketB : a.m_hash < b.m_hash;
+    });
+    int unique = 0;
+    for (int i = 0; i < keys.size(); i++) { //a word listed twice only needs one slot
+        if (unique > 0 && keys[unique - 1].m_hash == keys[i].m_hash) {
+            if (keys[unique - 1].m_word != keys[i].m_word) {
+                return false; //two different words with the same 64-bit hash can never get different slots
             }
+            continue;
         }
+        keys[unique++] = keys[i];
     }
-    return false;
+    keys.resize(unique);
+    vector<int> bucketStart(bucketCount + 1, 0);
+    for (int i = 0; i < keys.size(); i++) {
+        bucketStart[memberBucket(keys[i].m_hash, bucketCount) + 1]++;
+    }
+    for (int b = 0; b < bucketCount; b++) {
+        bucketStart[b + 1] += bucketStart[b];
+    }
+    vector<uint32_t> order(bucketCount);
+    for (int b = 0; b < bucketCount; b++) {
+        order[b] = b;
+    }
+    stable_sort(order.begin(), order.end(), [&bucketStart](uint32_t a, uint32_t b) { //place the biggest buckets while the table is still empty
+        return bucketStart[a + 1] - bucketStart[a] > bucketStart[b + 1] - bucketStart[b];
+    });
+    const uint32_t EMPTY = 0xFFFFFFFF;
+    displacements.assign(bucketCount, 0);
+    members.assign(keys.size(), EMPTY);
+    uint32_t slots[256];
+    for (int i = 0; i < bucketCount; i++) {
+        uint32_t b = order[i];
+        int size = bucketStart[b + 1] - bucketStart[b];
+        if (size == 0) {
+            break;
+        }
+        if (size > 256) {
+            return false;
+        }
+        for (uint32_t displacement = 0; ; displacement++) { //try displacements until every word in the bucket lands in a free slot of its own
+            if (displacement == MAX_DISPLACEMENT) {
+                return false;
+            }
+            bool fits = true;
+            for (int k = 0; k < size && fits; k++) {
+                slots[k] = memberSlot(keys[bucketStart[b] + k].m_hash, displacement, keys.size());
+                fits = members[slots[k]] == EMPTY && find(slots, slots + k, slots[k]) == slots + k;
+            }
+            if (fits) {
+                for (int k = 0; k < size; k++) {
+                    members[slots[k]] = keys[bucketStart[b] + k].m_offset;
+                }
+                displacements[b] = displacement;
+                break;
+            }
+        }
+    }
+    return true;
 }
 
-vector<string> WordListImpl::findCandidates(string cipherWord, string currTranslation) const
+int WordListImpl::findMember(string_view upperWord) const //the only dictionary word this can be is in its perfect hash slot
 {
-    vector<string> candidates;
-    if (cipherWord.length() != currTranslation.length() || invalidCipherWord(cipherWord) || invalidCurrTranslation(currTranslation) || invalidCorrespondingCharacters(cipherWord, currTranslation)) {
-        return candidates;
-    }
-    string CIPHERWORD = allCaps(cipherWord);
-    string CURRTRANSLATION = allCaps(currTranslation);
-    string pattern = generateWordPattern(CIPHERWORD);
-    const vector<string>* words = m_wordList.find(pattern);
-    if (words != nullptr) {
-        const vector<string> list = *words;
-        for (int i = 0; i < list.size(); i++) {
+    uint64_t h = wordHash(upperWord);
+    uint32_t displacement = m_displacements[memberBucket(h, m_header->m_memberBucketCount)];
+    uint32_t slot = memberSlot(h, displacement, m_header->m_memberCount);
+    const char* entry = m_arena + m_members[slot];
+    if ((unsigned char)entry[0] == upperWord.length() && memcmp(entry + 1, upperWord.data(), upperWord.length()) == 0) {
+        return slot;
+    }
+    return -1;
+}
+
+const SnapshotPattern* WordListImpl::candidatePattern(string_view cipherWord, string_view currTranslation, char* CURRTRANSLATION) const
+{
+    if (cipherWord.length() != currTranslation.length() || cipherWord.length() > MAX_WORD_LENGTH || invalidCipherWord(cipherWord) || invalidCurrTranslation(currTranslation) || invalidCorrespondingCharacters(cipherWord, currTranslation)) {
+        return nullptr;
+    }
+    char CIPHERWORD[MAX_WORD_LENGTH];
+    allCaps(cipherWord, CIPHERWORD);
+    allCaps(currTranslation, CURRTRANSLATION);
+    return findPattern(string_view(CIPHERWORD, cipherWord.length()));
+}
+
+int WordListImpl::matchCandidates(string_view cipherWord, string_view currTranslation, vector<string>* candidates, int limit) const
+{
+    char CURRTRANSLATION[MAX_WORD_LENGTH];
+    const SnapshotPattern* words = candidatePattern(cipherWord, currTranslation, CURRTRANSLATION);
+    if (words == nullptr) {
+        return 0;
+    }
+    const char* list = m_arena + words->m_wordsOffset;
+    int count = 0;
+    if (words->m_bitsets == NO_BITSETS) {
+        for (int i = 0; i < words->m_wordCount; i++) {
+            const char* word = list + i * (words->m_length + 1) + 1;
             bool push = true;
-            for (int j = 0; j < list[i].length(); j++) {
-                if ((isalpha(CURRTRANSLATION[j]) && CURRTRANSLATION[j] != list[i][j]) || (CURRTRANSLATION[j] == '?' && !isalpha(list[i][j])) || (CURRTRANSLATION[j] == '\'' && list[i][j] != '\'')) {
+            for (int j = 0; j < words->m_length; j++) {
+                if ((isLetter(CURRTRANSLATION[j]) && CURRTRANSLATION[j] != word[j]) || (CURRTRANSLATION[j] == '?' && !isLetter(word[j])) || (CURRTRANSLATION[j] == '\'' && word[j] != '\'')) {
                     push = false;
                 }
             }
             if (push) {
-                candidates.push_back(list[i]);
+                count++;
+                if (candidates != nullptr) {
+                    candidates->push_back(string(word, words->m_length));
+                }
+                if (count == limit) {
+                    break;
+                }
             }
         }
+        return count;
     }
-    return candidates;
+    //Every word here has the cipher word's pattern, so its apostrophes line up and it has letters wherever the
+    //translation has '?'. Only the letters already known need checking: one bitset per known letter.
+    int blocks = (words->m_wordCount + 63) / 64;
+    const uint64_t* known[MAX_WORD_LENGTH];
+    int knownCount = 0;
+    for (int j = 0; j < words->m_length; j++) {
+        if (isLetter(CURRTRANSLATION[j])) {
+            known[knownCount++] = m_bitsets + words->m_bitsets + (j * 26 + (CURRTRANSLATION[j] - 'A')) * blocks;
+        }
+    }
+    for (int b = 0; b < blocks; b++) {
+        uint64_t matches = ~uint64_t(0);
+        if (b == blocks - 1 && words->m_wordCount % 64 != 0) {
+            matches = (uint64_t(1) << (words->m_wordCount % 64)) - 1;
+        }
+        for (int k = 0; k < knownCount && matches != 0; k++) {
+            matches &= known[k][b];
+        }
+        while (matches != 0 && count < limit) {  //set bits are visited lowest first, so candidates stay in word list order
+            if (candidates == nullptr && limit - count >= 64) {
+                count += __builtin_popcountll(matches);
+                break;
+            }
+            int i = b * 64 + __builtin_ctzll(matches);
+            count++;
+            if (candidates != nullptr) {
+                candidates->push_back(string(list + i * (words->m_length + 1) + 1, words->m_length));
+            }
+            matches &= matches - 1;
+        }
+        if (count == limit) {
+            break;
+        }
+    }
+    return count;
 }
 
 //Private Functions
-bool WordListImpl::shouldIgnore(string file) const //ignore bad strings from input file
+bool WordListImpl::parseLine(const string& line, string& word, double& frequency) const //a word, optionally followed by whitespace and how often it occurs
 {
-    for (int i = 0; i < file.length(); i++) {
-        if (!isalpha(file[i]) && file[i] != '\'') {
-            return true;
-        }
+    size_t end = line.find_first_of(" \t");
+    word = line.substr(0, end);
+    frequency = -1;
+    if (end == string::npos) {
+        return true;
     }
-    return false;
+    const char* column = line.c_str() + end;
+    char* parsed;
+    frequency = strtod(column, &parsed);
+    while (*parsed == ' ' || *parsed == '\t' || *parsed == '\r') {
+        parsed++;
+    }
+    return parsed != column && *parsed == '\0' && frequency >= 0 && isfinite(frequency);
 }
 
-string WordListImpl::allCaps(string s) const
+bool WordListImpl::shouldIgnore(string file) const //ignore bad strings from input file
 {
-    string S = s;
-    for (int i = 0; i < S.length(); i++) {
-        S[i] = toupper(S[i]);
+    if (file.length() > MAX_WORD_LENGTH) {
+        return true;
     }
-    return S;
+    return !onlyWordCharacters(file, false);
+}
+
+void WordListImpl::allCaps(string_view s, char* buffer) const
+{
+    upperCase(s, buffer);
 }
 
-string WordListImpl::generateWordPattern(string s) const //associate each word in the word list with a pattern
+int WordListImpl::generateWordPattern(string_view s, char* buffer) const //associate each word in the word list with a pattern
 {
-    MyHash<char, char> generator;
+    char generator[26] = {}; //pattern letter assigned to each letter so far, 0 if not seen yet
     char c = 'A';
-    string pattern = "";
+    int length = 0;
     for (int i = 0; i < s.length(); i++) {
-        if (isalpha(s[i])) {
-            char* ch = generator.find(toupper(s[i])); //case insensitivity
-            if (ch == nullptr) {
-                pattern += c;
-                generator.associate(toupper(s[i]), c); //case insensitivity
+        if (isLetter(s[i])) {
+            char& ch = generator[(s[i] & ~0x20) - 'A']; //case insensitivity
+            if (ch == 0) {
+                ch = c;
                 c++;
             }
-            else{
-                pattern += *ch;
-            }
+            buffer[length++] = ch;
         }
         else if (s[i] == '\''){ //single quote
-            pattern += s[i];
-            generator.associate(s[i], s[i]);
+            buffer[length++] = s[i];
         }
     }
-    return pattern;
+    return length;
 }
 
-bool WordListImpl::invalidCipherWord(string s) const
+bool WordListImpl::invalidCipherWord(string_view s) const
 {
-    for (int i = 0; i < s.length(); i++) {
-        if (!isalpha(s[i]) && s[i] != '\'') {
-            return true;
-        }
-    }
-    return false;
+    return !onlyWordCharacters(s, false);
 }
 
-bool WordListImpl::invalidCurrTranslation(string s) const
+bool WordListImpl::invalidCurrTranslation(string_view s) const
 {
-    for (int i = 0; i < s.length(); i++) {
-        if (!isalpha(s[i]) && s[i] != '\'' && s[i] != '?') {
-            return true;
-        }
-    }
-    return false;
+    return !onlyWordCharacters(s, true);
 }
 
-bool WordListImpl::invalidCorrespondingCharacters(string s, string t) const
+bool WordListImpl::invalidCorrespondingCharacters(string_view s, string_view t) const
 {
     for (int i = 0; i < t.length(); i++) {
-        if ((isalpha(t[i]) && !isalpha(s[i])) || (t[i] == '?' && !isalpha(s[i])) || (t[i] == '\'' && s[i] != '\'')) {
+        if ((isLetter(t[i]) && !isLetter(s[i])) || (t[i] == '?' && !isLetter(s[i])) || (t[i] == '\'' && s[i] != '\'')) {
             return true;
         }
     }
@@ -182,6 +909,16 @@ unsigned int hash(const std::string& s)
     return std::hash<std::string>()(s);
 }
 
+unsigned int hash(const std::string_view& s) //agrees with hash(const std::string&), so MyHash<string, ...> can be searched with views
+{
+    return std::hash<std::string_view>()(s);
+}
+
+unsigned int hash(const PatternKey& key)
+{
+    return patternKeyHash(key);
+}
+
 unsigned int hash(const int& i)
 {
     return std::hash<int>()(i);
@@ -211,14 +948,39 @@ bool WordList::loadWordList(string filename)
     return m_impl->loadWordList(filename);
 }
 
-bool WordList::contains(string word) const
+bool WordList::saveSnapshot() const
+{
+    return m_impl->saveSnapshot();
+}
+
+bool WordList::contains(string_view word) const
 {
     return m_impl->contains(word);
 }
 
-vector<string> WordList::findCandidates(string cipherWord, string currTranslation) const
+vector<string> WordList::findCandidates(string_view cipherWord, string_view currTranslation) const
 {
     return m_impl->findCandidates(cipherWord, currTranslation);
 }
 
+int WordList::countCandidates(string_view cipherWord, string_view currTranslation) const
+{
+    return m_impl->countCandidates(cipherWord, currTranslation);
+}
+
+bool WordList::hasCandidates(string_view cipherWord, string_view currTranslation) const
+{
+    return m_impl->hasCandidates(cipherWord, currTranslation);
+}
+
+double WordList::logFrequency(string_view word) const
+{
+    return m_impl->logFrequency(word);
+}
+
+int WordList::candidateLetters(string_view cipherWord, string_view currTranslation, const unsigned int* allowed, unsigned int* support) const
+{
+    return m_impl->candidateLetters(cipherWord, currTranslation, allowed, support);
+}
+
 
@@ -1,18 +1,41 @@
 #include "provided.h"
 #include <iostream>
+#include <fstream>
 #include <string>
 #include <vector>
+#include <map>
 #include <cstring>
 #include <cctype>
+#include <cstdlib>
 #include <random>
 #include <algorithm>
 #include <numeric>
+#include <iterator>
+#include <unordered_set>
+#include <ctime>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <pthread.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <sys/time.h>
+#include "ThreadPool.h"
+#include "Protocol.h"
 #include <cassert> //testing purposes. Remember to comment out.
 #include "MyHash.h"  //testing MyHash purposes only. Remember to comment out after done.
 using namespace std;
 
-/*
 const string WORDLIST_FILE = "wordlist.txt";
+const int MESSAGES_PER_THREAD = 4;  //how far reading may run ahead of writing in streaming mode, per solver thread
+const int DEFAULT_DEADLINE_MS = 10000;  //how long the server cracks a message whose request gives no deadline
+const int REQUESTS_PER_WORKER = 4;  //requests that may wait for a free worker, per worker
+const int IDLE_TIMEOUT_SECONDS = 30;  //the server closes a connection that sends no request for this long
+const int SOCKET_TIMEOUT_SECONDS = 2;  //longest a worker waits on a client to send the rest of a request or take its answer
+const int POLL_INTERVAL_MS = 1000;  //how often the server looks for idle connections to close
 
 string encrypt(string plaintext)
 {
@@ -32,7 +55,32 @@ string encrypt(string plaintext)
 	return t.getTranslation(plaintext);
 }
 
-bool decrypt(string ciphertext)
+//Writes the counts of a detailed crack as one JSON object on one line.
+void writeStats(ostream& out, const CrackStats& stats)
+{
+	out << "{\"nodes\": " << stats.m_nodesExpanded
+	    << ", \"pushes\": " << stats.m_pushes
+	    << ", \"pops\": " << stats.m_pops
+	    << ", \"rejected\": {\"conflicting\": " << stats.m_rejectedConflicting
+	    << ", \"domains\": " << stats.m_rejectedByDomains << "}"
+	    << ", \"pruned\": {\"notInList\": " << stats.m_prunedNotInList
+	    << ", \"noCandidates\": " << stats.m_prunedNoCandidates
+	    << ", \"propagation\": " << stats.m_prunedByPropagation
+	    << ", \"repeated\": " << stats.m_prunedRepeated << "}"
+	    << ", \"candidateHistogram\": [";
+	for (int b = 0; b < CANDIDATE_HISTOGRAM_BUCKETS; b++)
+		out << (b == 0 ? "" : ", ") << stats.m_candidateHistogram[b];
+	out << "], \"maxDepth\": " << stats.m_maxDepth
+	    << ", \"ms\": {\"prepare\": " << stats.m_prepareMs
+	    << ", \"candidates\": " << stats.m_candidatesMs
+	    << ", \"check\": " << stats.m_checkMs
+	    << ", \"sort\": " << stats.m_sortMs
+	    << ", \"wall\": " << stats.m_wallMs << "}}" << endl;
+}
+
+//Prints every decryption of ciphertext; with showStats, also the search's counts as JSON, on standard error so the
+//decryptions on standard output stay the same.
+bool decrypt(string ciphertext, bool showStats)
 {
 	Decrypter d;
 	if ( ! d.load(WORDLIST_FILE))
@@ -40,13 +88,404 @@ bool decrypt(string ciphertext)
 		cout << "Unable to load word list file " << WORDLIST_FILE << endl;
 		return false;
 	}
-	for (const auto& s : d.crack(ciphertext))
+	CrackStats stats;
+	stats.m_detailed = showStats;
+	for (const auto& s : d.crack(ciphertext, showStats ? &stats : nullptr))
 		cout << s << endl;
+	if (showStats)
+		writeStats(cerr, stats);
+	return true;
+}
+
+//The compile step for a word list: writes filename + ".snapshot", which later loads of filename map instead of
+//parsing the text, until the text file changes.
+bool compileSnapshot(const string& filename)
+{
+	WordList wl;
+	if ( ! wl.loadWordList(filename)  ||  ! wl.saveSnapshot())
+		return false;
+	cout << filename << ".snapshot is up to date" << endl;
 	return true;
 }
 
+struct Message{
+    long m_number;  //line number in the input
+    string m_ciphertext;
+};
+
+struct Solved{
+    long m_number;
+    vector<string> m_decryptions;
+};
+
+//Lets at most limit messages be between reading and writing at once. Writing in input order has to hold on to
+//messages that finish early, and this keeps those, like everything else in the pipeline, bounded.
+class InFlightLimit
+{
+public:
+    InFlightLimit(int limit): m_limit(limit), m_inFlight(0) {}
+    void acquire()
+    {
+        unique_lock<mutex> guard(m_lock);
+        m_roomLeft.wait(guard, [this] { return m_inFlight < m_limit; });
+        m_inFlight++;
+    }
+    void release()
+    {
+        lock_guard<mutex> guard(m_lock);
+        m_inFlight--;
+        m_roomLeft.notify_one();
+    }
+private:
+    mutex m_lock;
+    condition_variable m_roomLeft;
+    int m_limit;
+    int m_inFlight;
+};
+
+void writeDecryptions(const Solved& solved)
+{
+    cout << "Message " << solved.m_number << ": " << solved.m_decryptions.size() << " decryptions\n";
+    for (const auto& s : solved.m_decryptions)
+        cout << s << '\n';
+    cout << flush;  //each message is written out as soon as it is done
+}
+
+//Cracks every line of in as a separate message, loading the word list once. One thread reads, threads solver
+//threads crack, and this thread writes each message's decryptions as it finishes, either in input order or in
+//the order the messages complete. The stages are joined by bounded queues, so memory use doesn't grow with the input.
+bool stream(istream& in, int threads, bool completionOrder)
+{
+    Decrypter d;
+    if (!d.load(WORDLIST_FILE)) {
+        cout << "Unable to load word list file " << WORDLIST_FILE << endl;
+        return false;
+    }
+    int capacity = threads * MESSAGES_PER_THREAD;
+    BoundedQueue<Message> messages(capacity);
+    BoundedQueue<Solved> solved(capacity);
+    InFlightLimit inFlight(capacity);
+    thread reader([&in, &messages, &inFlight] {
+        Message message;
+        message.m_number = 0;
+        while (getline(in, message.m_ciphertext)) {
+            inFlight.acquire();
+            message.m_number++;
+            messages.push(message);
+        }
+        messages.close();
+    });
+    atomic<int> running(threads);
+    vector<thread> solvers;
+    for (int i = 0; i < threads; i++) {
+        solvers.push_back(thread([&d, &messages, &solved, &running] {
+            Message message;
+            while (messages.pop(message)) {
+                solved.push({message.m_number, d.crack(message.m_ciphertext)});
+            }
+            if (--running == 0) { //the last solver to finish ends the output
+                solved.close();
+            }
+        }));
+    }
+    map<long, vector<string>> early;  //messages done before some message read ahead of them, in input order
+    long next = 1;
+    Solved done;
+    while (solved.pop(done)) {
+        if (completionOrder) {
+            writeDecryptions(done);
+            inFlight.release();
+            continue;
+        }
+        early[done.m_number] = move(done.m_decryptions);
+        while (!early.empty() && early.begin()->first == next) {
+            writeDecryptions({next, move(early.begin()->second)});
+            early.erase(early.begin());
+            next++;
+            inFlight.release();
+        }
+    }
+    reader.join();
+    for (int i = 0; i < solvers.size(); i++) {
+        solvers[i].join();
+    }
+    return true;
+}
+
+//A connection whose next request is ready to be read, waiting for a worker
+struct ReadyConnection{
+    int m_fd;
+    chrono::steady_clock::time_point m_readyAt;  //when the server saw the request arrive: its deadline counts from then
+};
+
+//Connections workers are done with, on their way back to the server's poll loop, which a byte on a pipe wakes.
+//The same pipe carries the stop signal.
+class Handback
+{
+public:
+    Handback(): m_stopping(false)
+    {
+        if (pipe(m_pipe) < 0) {
+            m_pipe[0] = m_pipe[1] = -1;
+        }
+    }
+    ~Handback()
+    {
+        close(m_pipe[0]);
+        close(m_pipe[1]);
+    }
+    bool ok() const
+    {
+        return m_pipe[0] >= 0;
+    }
+    int wakeFd() const  //readable whenever there is something to take
+    {
+        return m_pipe[0];
+    }
+    void giveBack(int fd)  //fd is idle again; -1 if the worker closed it
+    {
+        {
+            lock_guard<mutex> guard(m_lock);
+            m_returned.push_back(fd);
+        }
+        wake();
+    }
+    void stop()
+    {
+        m_stopping = true;
+        wake();
+    }
+    bool stopping() const
+    {
+        return m_stopping;
+    }
+    vector<int> take()  //the connections given back since the last take, including the -1s
+    {
+        char bytes[64];
+        while (read(m_pipe[0], bytes, sizeof(bytes)) == sizeof(bytes)) {
+        }
+        lock_guard<mutex> guard(m_lock);
+        vector<int> returned;
+        returned.swap(m_returned);
+        return returned;
+    }
+      // We prevent a Handback object from being copied or assigned.
+    Handback(const Handback&) = delete;
+    Handback& operator=(const Handback&) = delete;
+private:
+    int m_pipe[2];
+    mutex m_lock;
+    vector<int> m_returned;
+    atomic<bool> m_stopping;
+    void wake()
+    {
+        char byte = 0;
+        ssize_t written = write(m_pipe[1], &byte, 1); //a full pipe is already awake
+        (void)written;
+    }
+};
+
+//Cracks a request's ciphertext within its limits, or the server's default deadline if it gives none.
+CrackResponse answer(const Decrypter& d, const CrackRequest& request, chrono::steady_clock::time_point readyAt, int defaultDeadlineMs)
+{
+    CrackLimits limits;
+    limits.m_maxResults = request.m_maxResults;
+    limits.m_deadline = readyAt + chrono::milliseconds(request.m_deadlineMs != 0 ? request.m_deadlineMs : defaultDeadlineMs);
+    CrackResponse response;
+    bool complete;
+    if (request.m_flags & REQUEST_RANKED) {
+        for (auto& ranked : d.crackRanked(request.m_ciphertext, limits, &complete)) {
+            response.m_decryptions.push_back(move(ranked.m_decryption));
+        }
+    }
+    else {
+        response.m_decryptions = d.crack(request.m_ciphertext, limits, &complete);
+    }
+    response.m_status = complete ? RESPONSE_COMPLETE : RESPONSE_STOPPED;
+    return response;
+}
+
+//Reads one request from a connection and answers it; false if the connection is finished with
+bool serveRequest(const Decrypter& d, const ReadyConnection& ready, int defaultDeadlineMs)
+{
+    string payload;
+    if (!readFrame(ready.m_fd, payload)) { //the client hung up, or started a request and didn't finish it in time
+        return false;
+    }
+    CrackRequest request;
+    CrackResponse response;  //a bad request's response says so
+    if (decodeRequest(payload, request)) {
+        response = answer(d, request, ready.m_readyAt, defaultDeadlineMs);
+    }
+    return writeFrame(ready.m_fd, encodeResponse(response));
+}
+
+//Loads the word list once, then answers requests on the Unix domain socket at path (see Protocol.h) until SIGINT
+//or SIGTERM. This thread polls the listening socket and every idle connection; each request that arrives is handed
+//to the pool of worker threads, which read it, crack it with its deadline and answer it, then hand the connection
+//back. No worker waits on a client between requests, and timeouts on every socket keep a client that stalls
+//halfway through sending a request, or stops reading its answer, from holding a worker for long. On a stop signal
+//the server stops accepting, answers the requests already handed out, and removes the socket.
+bool serve(const char* path, int workers, int defaultDeadlineMs)
+{
+    Decrypter d;
+    if (!d.load(WORDLIST_FILE)) {
+        cout << "Unable to load word list file " << WORDLIST_FILE << endl;
+        return false;
+    }
+    sigset_t stopSignals;  //blocked in every thread, and taken by sigwait instead of the default handler
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+    int listener = listenUnix(path, SOMAXCONN);
+    if (listener < 0) {
+        cout << "Unable to listen on " << path << endl;
+        return false;
+    }
+    Handback handback;
+    if (!handback.ok()) {
+        cout << "Unable to create a pipe" << endl;
+        close(listener);
+        return false;
+    }
+    fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK); //a client that gave up between poll and accept mustn't block the loop
+    fcntl(handback.wakeFd(), F_SETFL, fcntl(handback.wakeFd(), F_GETFL) | O_NONBLOCK);
+    int capacity = workers * REQUESTS_PER_WORKER;
+    BoundedQueue<ReadyConnection> ready(capacity);
+    vector<thread> pool;
+    for (int i = 0; i < workers; i++) {
+        pool.push_back(thread([&d, &ready, &handback, defaultDeadlineMs] {
+            ReadyConnection connection;
+            while (ready.pop(connection)) {
+                if (serveRequest(d, connection, defaultDeadlineMs)) {
+                    handback.giveBack(connection.m_fd);
+                }
+                else {
+                    close(connection.m_fd);
+                    handback.giveBack(-1);
+                }
+            }
+        }));
+    }
+    thread([stopSignals, &handback]() mutable { //never joined: it lives until a stop signal, and then ends with the process
+        int signal;
+        sigwait(&stopSignals, &signal);
+        handback.stop();
+    }).detach();
+    cout << "Serving on " << path << " with " << workers << " workers" << endl;
+    struct IdleConnection{
+        int m_fd;
+        chrono::steady_clock::time_point m_since;
+    };
+    vector<IdleConnection> idle;
+    vector<pollfd> polled;
+    int handedOut = 0;  //requests in the queue or with a worker; at capacity, idle connections wait unpolled
+    while (!handback.stopping()) {
+        polled.clear();
+        polled.push_back({handback.wakeFd(), POLLIN, 0});
+        polled.push_back({listener, POLLIN, 0});
+        int pollIdle = handedOut < capacity ? idle.size() : 0;
+        for (int i = 0; i < pollIdle; i++) {
+            polled.push_back({idle[i].m_fd, POLLIN, 0});
+        }
+        if (poll(polled.data(), polled.size(), POLL_INTERVAL_MS) < 0 && errno != EINTR) {
+            break;
+        }
+        auto now = chrono::steady_clock::now();
+        vector<IdleConnection> stillIdle;
+        for (int i = 0; i < idle.size(); i++) {
+            short events = i < pollIdle ? polled[i + 2].revents : 0;
+            bool quiet = i < pollIdle && events == 0;  //listened to, and the client sent nothing
+            if (events != 0 && handedOut < capacity) { //a request, or the client hung up, which the worker finds out
+                ready.push({idle[i].m_fd, now});
+                handedOut++;
+            }
+            else if (quiet && now - idle[i].m_since >= chrono::seconds(IDLE_TIMEOUT_SECONDS)) {
+                close(idle[i].m_fd);
+            }
+            else {
+                if (!quiet) { //waiting on the server, not the client, which may have a request in already: that isn't idle time
+                    idle[i].m_since = now;
+                }
+                stillIdle.push_back(idle[i]);
+            }
+        }
+        idle.swap(stillIdle);
+        if (polled[0].revents != 0) {
+            for (int fd : handback.take()) {
+                handedOut--;
+                if (fd >= 0) {
+                    idle.push_back({fd, now});
+                }
+            }
+        }
+        if (polled[1].revents != 0) {
+            int fd;
+            while ((fd = accept(listener, nullptr, nullptr)) >= 0) {
+                timeval timeout = {SOCKET_TIMEOUT_SECONDS, 0};
+                setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+                setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+                ignoreSigpipe(fd);
+                idle.push_back({fd, now});
+            }
+        }
+    }
+    ready.close();
+    for (int i = 0; i < pool.size(); i++) {
+        pool[i].join();
+    }
+    for (int fd : handback.take()) {
+        if (fd >= 0) {
+            close(fd);
+        }
+    }
+    for (int i = 0; i < idle.size(); i++) {
+        close(idle[i].m_fd);
+    }
+    close(listener);
+    unlink(path);
+    return true;
+}
+
+//Sends ciphertext to the server at path and prints the decryptions it answers with, like -d does.
+bool requestCrack(const char* path, const CrackRequest& request)
+{
+    int fd = connectUnix(path);
+    if (fd < 0) {
+        cout << "Unable to connect to " << path << endl;
+        return false;
+    }
+    string payload;
+    CrackResponse response;
+    bool ok = writeFrame(fd, encodeRequest(request)) && readFrame(fd, payload) && decodeResponse(payload, response);
+    close(fd);
+    if (!ok) {
+        cout << "No answer from " << path << endl;
+        return false;
+    }
+    if (response.m_status == RESPONSE_BAD_REQUEST) {
+        cout << "The server couldn't read the request" << endl;
+        return false;
+    }
+    for (const auto& s : response.m_decryptions) {
+        cout << s << endl;
+    }
+    if (response.m_status == RESPONSE_STOPPED) {
+        cerr << "Stopped at the deadline or the most decryptions; there may be more" << endl;
+    }
+    return true;
+}
+
+int testMyHash();
+int testWordList();
+int testSnapshots();
+int testDecrypter();
+
 int main(int argc, char* argv[])
 {
+	if (argc == 1)
+		return testMyHash() != 0  ||  testWordList() != 0  ||  testSnapshots() != 0  ||  testDecrypter() != 0;
 	if (argc == 3  &&  argv[1][0] == '-')
 	{
 		switch (tolower(argv[1][1]))
@@ -55,19 +494,103 @@ int main(int argc, char* argv[])
 			cout << encrypt(argv[2]) << endl;
 			return 0;
 		  case 'd':
-			if (decrypt(argv[2]))
+			if (decrypt(argv[2], false))
 				return 0;
 			return 1;
 		}
 	}
+	if (argc == 4  &&  strcmp(argv[1], "-d") == 0  &&  strcmp(argv[2], "--stats") == 0)
+		return decrypt(argv[3], true) ? 0 : 1;
+	if (argc == 3  &&  strcmp(argv[1], "--compile-snapshot") == 0)
+		return compileSnapshot(argv[2]) ? 0 : 1;
+	if (argc >= 3  &&  strcmp(argv[1], "--serve") == 0)
+	{
+		int workers = max(1u, thread::hardware_concurrency());
+		int deadlineMs = DEFAULT_DEADLINE_MS;
+		bool ok = true;
+		for (int i = 3; i < argc  &&  ok; i++)
+		{
+			if (strcmp(argv[i], "-j") == 0  &&  i + 1 < argc)
+				workers = max(1, atoi(argv[++i]));
+			else if (strcmp(argv[i], "-t") == 0  &&  i + 1 < argc)
+				deadlineMs = max(1, atoi(argv[++i]));
+			else
+				ok = false;
+		}
+		if (ok)
+			return serve(argv[2], workers, deadlineMs) ? 0 : 1;
+	}
+	if (argc >= 4  &&  strcmp(argv[1], "--client") == 0)
+	{
+		CrackRequest request;
+		bool ok = true;
+		int i;
+		for (i = 3; i < argc - 1  &&  ok; i++)
+		{
+			if (strcmp(argv[i], "-t") == 0  &&  i + 1 < argc - 1)
+				request.m_deadlineMs = max(1, atoi(argv[++i]));
+			else if (strcmp(argv[i], "-n") == 0  &&  i + 1 < argc - 1)
+				request.m_maxResults = max(1, atoi(argv[++i]));
+			else if (strcmp(argv[i], "-r") == 0)
+				request.m_flags |= REQUEST_RANKED;
+			else
+				ok = false;
+		}
+		if (ok  &&  i == argc - 1)
+		{
+			request.m_ciphertext = argv[argc - 1];
+			return requestCrack(argv[2], request) ? 0 : 1;
+		}
+	}
+	if (argc >= 2  &&  strcmp(argv[1], "-s") == 0)
+	{
+		int threads = max(1u, thread::hardware_concurrency());
+		bool completionOrder = false;
+		const char* filename = nullptr;
+		bool ok = true;
+		for (int i = 2; i < argc  &&  ok; i++)
+		{
+			if (strcmp(argv[i], "-j") == 0  &&  i + 1 < argc)
+				threads = max(1, atoi(argv[++i]));
+			else if (strcmp(argv[i], "-c") == 0)
+				completionOrder = true;
+			else if (filename == nullptr  &&  (argv[i][0] != '-'  ||  strcmp(argv[i], "-") == 0))
+				filename = argv[i];
+			else
+				ok = false;
+		}
+		if (ok)
+		{
+			if (filename == nullptr  ||  strcmp(filename, "-") == 0)
+				return stream(cin, threads, completionOrder) ? 0 : 1;
+			ifstream infile(filename);
+			if ( ! infile)
+			{
+				cout << "Unable to open " << filename << endl;
+				return 1;
+			}
+			return stream(infile, threads, completionOrder) ? 0 : 1;
+		}
+	}
 
 	cout << "Usage to encrypt:  " << argv[0] << " -e \"Your message here.\"" << endl;
-	cout << "Usage to decrypt:  " << argv[0] << " -d \"Uwey tirrboi miyi.\"" << endl;
+	cout << "Usage to decrypt:  " << argv[0] << " -d [--stats] \"Uwey tirrboi miyi.\"" << endl;
+	cout << "                   --stats also writes the search's counts and timings to standard error as JSON" << endl;
+	cout << "Usage to decrypt one message per line of a file, or of standard input if there is no file or it is -:" << endl;
+	cout << "                   " << argv[0] << " -s [-j threads] [-c] [file]" << endl;
+	cout << "                   -c writes each message as soon as it is done instead of in input order" << endl;
+	cout << "Usage to compile a word list into the snapshot loading it maps instead of parsing it:" << endl;
+	cout << "                   " << argv[0] << " --compile-snapshot " << WORDLIST_FILE << endl;
+	cout << "Usage to serve decryptions on a Unix domain socket, loading the word list once:" << endl;
+	cout << "                   " << argv[0] << " --serve socket [-j workers] [-t default deadline ms]" << endl;
+	cout << "Usage to decrypt through a server:" << endl;
+	cout << "                   " << argv[0] << " --client socket [-t deadline ms] [-n most decryptions] [-r] \"Uwey tirrboi miyi.\"" << endl;
+	cout << "                   -r asks for the likeliest decryptions first" << endl;
+	cout << "Usage to test MyHash, and the word list and decrypter too if " << WORDLIST_FILE << " is there:  " << argv[0] << endl;
 	return 1;
 }
-*/
 
-int main()
+int testMyHash()
 {
     MyHash<string, int> m_hash;
     string key = "";
@@ -81,7 +604,7 @@ int main()
         key += "a";
     }
     assert(m_hash.getNumItems() == 51);
-    assert(m_hash.getLoadFactor() == 0.255);
+    assert(m_hash.getLoadFactor() == 0.3984375);
     int* ptr = m_hash.find("aaa");
     assert(ptr != nullptr);
     assert(*ptr == 3);
@@ -97,7 +620,7 @@ int main()
         key2 += "b";
     }
     assert(m_hash.getNumItems() == 101);
-    assert(m_hash.getLoadFactor() == 0.2525);
+    assert(m_hash.getLoadFactor() == 0.39453125);
     m_hash.associate("", 999);
     assert(m_hash.getNumItems() == 101);
     int* ptr3 = m_hash.find("");
@@ -108,10 +631,290 @@ int main()
     assert(ptr4 != nullptr && *ptr4 == 875);
     m_hash.associate("Trump", -32);
     assert(m_hash.getNumItems() == 102);
-    assert(m_hash.getLoadFactor() == 0.255);
+    assert(m_hash.getLoadFactor() == 0.3984375);
     m_hash.associate("Kim Jong Un", -98);
     assert(m_hash.getNumItems() == 103);
-    assert(m_hash.getLoadFactor() == 0.2575);
+    assert(m_hash.getLoadFactor() == 0.40234375);
+    MyHash<int, int> clustered; //every key's hash is a multiple of the table size, so probe lengths overflow a byte until the table grows
+    for (int i = 0; i < 300; i++) {
+        clustered.associate(i << 16, i);
+    }
+    assert(clustered.getNumItems() == 300);
+    for (int i = 0; i < 300; i++) {
+        int* valuePtr = clustered.find(i << 16);
+        assert(valuePtr != nullptr && *valuePtr == i);
+    }
+    assert(clustered.find(1) == nullptr);
     cout << "MyHash works!" << endl;
     return 0;
 }
+
+//a temporary copy of the word list at from, with every word in it copies times; "" if it can't be written
+string copyWordList(const string& from, int copies)
+{
+    ifstream in(from);
+    if ( ! in)
+        return "";
+    string words((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+    char path[] = "/tmp/crackedXXXXXX";
+    int fd = mkstemp(path);
+    if (fd < 0)
+        return "";
+    close(fd);
+    ofstream out(path);
+    for (int i = 0; i < copies; i++)
+        out << words << (words.empty() || words.back() == '\n' ? "" : "\n");
+    return out ? path : "";
+}
+
+int testDecrypter()
+{
+    Decrypter d;
+    if ( ! d.load(WORDLIST_FILE))
+    {
+        cout << "No " << WORDLIST_FILE << ", so the decrypter isn't tested" << endl;
+        return 0;
+    }
+    const string message = "Jd az dy bdj jd az, jmxj on jmz qgznjodb.";
+    vector<string> serial = d.crack(message);
+    assert( ! serial.empty());
+    assert(adjacent_find(serial.begin(), serial.end()) == serial.end());
+
+      // a word list listing every word twice gives the same decryptions, each once, at any thread count
+    string twice = copyWordList(WORDLIST_FILE, 2);
+    assert( ! twice.empty());
+    Decrypter repeated;
+    assert(repeated.load(twice));
+    for (int threads : {1, 2, 3, 4, 5, 7, 8, 16})
+    {
+        repeated.setThreadCount(threads);
+        assert(repeated.crack(message) == serial);
+    }
+    unlink(twice.c_str());
+
+      // a result cap stops the search as soon as it is reached, and the crack then isn't complete
+    CrackLimits limits;
+    limits.m_maxResults = 3;
+    bool complete;
+    vector<string> capped = d.crack(message, limits, &complete);
+    assert(capped.size() == 3  &&  ! complete);
+    limits.m_maxResults = serial.size() + 1;
+    assert(d.crack(message, limits, &complete) == serial  &&  complete);
+    cout << "Decrypter works!" << endl;
+    return 0;
+}
+
+//the letter pattern of an upper case word: "ABCCBA" for "ZYXXYZ", apostrophes kept
+string letterPattern(const string& word)
+{
+    string pattern;
+    char assigned[26] = {};
+    char next = 'A';
+    for (char ch : word) {
+        if (ch == '\'') {
+            pattern += ch;
+            continue;
+        }
+        if (assigned[ch - 'A'] == 0)
+            assigned[ch - 'A'] = next++;
+        pattern += assigned[ch - 'A'];
+    }
+    return pattern;
+}
+
+int testWordList()
+{
+    WordList wl;
+    ifstream infile(WORDLIST_FILE);
+    if ( ! infile  ||  ! wl.loadWordList(WORDLIST_FILE))
+    {
+        cout << "No " << WORDLIST_FILE << ", so the word list isn't tested" << endl;
+        return 0;
+    }
+      // the reference: every word of the file, upper case, grouped by pattern in file order, scanned one by one
+    map<string, vector<string>> byPattern;
+    vector<string> words;
+    string line;
+    while (getline(infile, line))
+    {
+        if (line.empty()  ||  line.length() > 64  ||  line.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz'") != string::npos)
+            continue;
+        for (char& ch : line)
+            ch = toupper(ch);
+        byPattern[letterPattern(line)].push_back(line);
+        words.push_back(line);
+    }
+    assert( ! words.empty());
+
+      // random queries against positional bitsets and plain scans alike: a word encrypted with a random key, some of
+      // its letters already translated, and random letters allowed at each position
+    mt19937 random(2018);
+    for (int query = 0; query < 3000; query++)
+    {
+        const string& plain = words[random() % words.size()];
+        string key = "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+        shuffle(key.begin(), key.end(), random);
+        unsigned int revealed = random() & ((1u << 26) - 1);
+        string cipherWord = plain;
+        string translation = plain;
+        vector<unsigned int> allowed(plain.length());
+        for (int j = 0; j < plain.length(); j++)
+        {
+            allowed[j] = random() & ((1u << 26) - 1);
+            if (plain[j] == '\'')
+                continue;
+            cipherWord[j] = key[plain[j] - 'A'];
+            if ( ! (revealed >> (plain[j] - 'A') & 1))
+                translation[j] = '?';
+        }
+        vector<string> expected;
+        int expectedFitting = 0;
+        vector<unsigned int> expectedSupport(plain.length(), 0);
+        for (const string& word : byPattern[letterPattern(plain)])
+        {
+            bool matches = true;
+            bool fits = true;
+            for (int j = 0; j < word.length(); j++)
+            {
+                if (translation[j] != '?'  &&  translation[j] != word[j])
+                    matches = fits = false;
+                else if (translation[j] == '?'  &&  ! (allowed[j] >> (word[j] - 'A') & 1))
+                    fits = false;
+            }
+            if (matches)
+                expected.push_back(word);
+            if (fits)
+            {
+                expectedFitting++;
+                for (int j = 0; j < word.length(); j++)
+                    if (word[j] != '\'')
+                        expectedSupport[j] |= 1u << (word[j] - 'A');
+            }
+        }
+        assert(wl.findCandidates(cipherWord, translation) == expected);
+        assert(wl.countCandidates(cipherWord, translation) == expected.size());
+        assert(wl.hasCandidates(cipherWord, translation) == ! expected.empty());
+        vector<unsigned int> support(plain.length());
+        assert(wl.candidateLetters(cipherWord, translation, allowed.data(), support.data()) == expectedFitting);
+        assert(support == expectedSupport);
+    }
+    cout << "WordList works!" << endl;
+    return 0;
+}
+
+//writes text to path and sets its modification time to modified
+void writeFile(const string& path, const string& text, time_t modified)
+{
+    ofstream out(path);
+    out << text;
+    out.close();
+    timeval times[2] = {{modified, 0}, {modified, 0}};
+    utimes(path.c_str(), times);
+}
+
+//sets the snapshot version in the header of the snapshot at path to version
+void setSnapshotVersion(const string& path, uint32_t version)
+{
+    fstream snapshot(path, ios::in | ios::out | ios::binary);
+    snapshot.seekp(8);  //after the magic number
+    snapshot.write(reinterpret_cast<const char*>(&version), sizeof(version));
+}
+
+//fills every slot of the pattern index of the snapshot at path, as damage might, so a probe would never end
+void fillSnapshotIndex(const string& path)
+{
+    fstream snapshot(path, ios::in | ios::out | ios::binary);
+    uint32_t indexSize;
+    uint64_t indexOffset;
+    snapshot.seekg(44);  //the index's size, then the patterns' offset, then the index's
+    snapshot.read(reinterpret_cast<char*>(&indexSize), sizeof(indexSize));
+    snapshot.seekg(56);
+    snapshot.read(reinterpret_cast<char*>(&indexOffset), sizeof(indexOffset));
+    vector<uint32_t> index(indexSize, 1);
+    snapshot.seekp(indexOffset);
+    snapshot.write(reinterpret_cast<const char*>(index.data()), indexSize * sizeof(uint32_t));
+}
+
+//checks contains against a hash set of the words, for words in the list and words just like them that aren't
+void checkContains(const WordList& wl, const vector<string>& words)
+{
+    unordered_set<string> present(words.begin(), words.end());
+    mt19937 random(2018);
+    for (int query = 0; query < 3000; query++)
+    {
+        string word = words[random() % words.size()];
+        assert(wl.contains(word));
+        string lower = word;
+        for (char& ch : lower)
+            ch = tolower(ch);
+        assert(wl.contains(lower));
+        int j = random() % word.length();
+        if (word[j] != '\'')
+            word[j] = 'A' + random() % 26;
+        word += random() % 4 == 0 ? "S" : "";
+        assert(wl.contains(word) == (present.count(word) != 0));
+    }
+    assert( ! wl.contains(""));
+    assert( ! wl.contains("QQQQQQQQQ"));
+    assert( ! wl.contains(string(100, 'A')));
+}
+
+int testSnapshots()
+{
+    ifstream infile(WORDLIST_FILE);
+    if ( ! infile)
+    {
+        cout << "No " << WORDLIST_FILE << ", so snapshots aren't tested" << endl;
+        return 0;
+    }
+    vector<string> words;
+    string line;
+    while (getline(infile, line))
+    {
+        if ( ! line.empty()  &&  line.length() <= 64  &&  line.find_first_not_of("ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz'") == string::npos)
+        {
+            for (char& ch : line)
+                ch = toupper(ch);
+            words.push_back(line);
+        }
+    }
+
+      // the perfect hash behind contains agrees with a hash set, both built from the text and mapped from a snapshot
+    string copy = copyWordList(WORDLIST_FILE, 1);
+    assert( ! copy.empty());
+    WordList fromText;
+    assert(fromText.loadWordList(copy));
+    checkContains(fromText, words);
+    assert(fromText.saveSnapshot());
+    WordList fromSnapshot;
+    assert(fromSnapshot.loadWordList(copy));
+    checkContains(fromSnapshot, words);
+    unlink(copy.c_str());
+    unlink((copy + ".snapshot").c_str());
+
+      // an up to date snapshot is used instead of the text; a stale one, one of another version, or a damaged one is not
+    string path = copyWordList(WORDLIST_FILE, 0);  //an empty temporary file
+    assert( ! path.empty());
+    string snapshot = path + ".snapshot";
+    time_t modified = time(nullptr) - 1000;
+    writeFile(path, "apple\nberry\n", modified);
+    WordList wl;
+    assert(wl.loadWordList(path)  &&  wl.saveSnapshot());
+    writeFile(path, "lemon\ngrape\n", modified);  //same size and time: the snapshot still looks up to date
+    assert(wl.loadWordList(path)  &&  wl.contains("apple")  &&  ! wl.contains("lemon"));
+    writeFile(path, "lemon\ngrape\n", modified + 1);
+    assert(wl.loadWordList(path)  &&  wl.contains("lemon")  &&  ! wl.contains("apple"));
+    writeFile(path, "lemon\ngrape\n", modified);
+    assert(wl.loadWordList(path)  &&  wl.contains("apple"));
+    setSnapshotVersion(snapshot, 0);
+    assert(wl.loadWordList(path)  &&  wl.contains("lemon")  &&  ! wl.contains("apple"));
+    writeFile(path, "apple\nberry\n", modified);
+    assert(wl.loadWordList(path)  &&  wl.saveSnapshot());
+    writeFile(path, "lemon\ngrape\n", modified);
+    fillSnapshotIndex(snapshot);
+    assert(wl.loadWordList(path)  &&  wl.contains("lemon")  &&  ! wl.contains("apple"));
+    unlink(path.c_str());
+    unlink(snapshot.c_str());
+    cout << "Snapshots work!" << endl;
+    return 0;
+}
@@ -2,7 +2,29 @@
 #define PROVIDED_INCLUDED
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <chrono>
+#include <functional>
+
+  // A set of characters as a 256-bit table, so membership is one shift and mask; can be built at compile time.
+class CharacterSet
+{
+public:
+    constexpr CharacterSet(std::string_view chars): m_bits{0, 0, 0, 0}
+    {
+        for (unsigned char c : chars) {
+            m_bits[c >> 6] |= 1ull << (c & 63);
+        }
+    }
+    constexpr bool contains(char ch) const
+    {
+        unsigned char c = ch;
+        return (m_bits[c >> 6] >> (c & 63)) & 1;
+    }
+private:
+    unsigned long long m_bits[4];
+};
 
 class TokenizerImpl;
 
@@ -10,8 +32,12 @@ class Tokenizer
 {
 public:
     Tokenizer(std::string separators);
+    Tokenizer(const CharacterSet& separators);
     ~Tokenizer();
     std::vector<std::string> tokenize(const std::string& s) const;
+      // replaces the contents of tokens with views into s, which must outlive them; no heap work once tokens
+      // has grown to fit, so reuse the same vector across calls
+    void tokenize(std::string_view s, std::vector<std::string_view>& tokens) const;
       // We prevent a Tokenizer object from being copied or assigned.
     Tokenizer(const Tokenizer&) = delete;
     Tokenizer& operator=(const Tokenizer&) = delete;
@@ -26,9 +52,19 @@ class WordList
 public:
     WordList();
     ~WordList();
+      // uses the compiled snapshot filename + ".snapshot" when it is up to date, else reads the text file
     bool loadWordList(std::string filename);
-    bool contains(std::string word) const;
-    std::vector<std::string> findCandidates(std::string cipherWord, std::string currTranslation) const;
+    bool saveSnapshot() const; // compiles the word list loaded from a text file into its snapshot
+    bool contains(std::string_view word) const;
+    std::vector<std::string> findCandidates(std::string_view cipherWord, std::string_view currTranslation) const;
+    int countCandidates(std::string_view cipherWord, std::string_view currTranslation) const; // findCandidates(...).size() without building the strings
+    bool hasCandidates(std::string_view cipherWord, std::string_view currTranslation) const; // countCandidates(...) != 0, stopping at the first candidate
+      // natural log of word's share of the word list's frequency column (each line may be "word count"), or -HUGE_VAL
+      // if word isn't in the list; every word gets 0 if the list has no frequency column
+    double logFrequency(std::string_view word) const;
+      // counts the candidates whose letter at each position j is one of allowed[j] (bit c stands for 'A' + c), and sets
+      // support[j] to the letters those candidates have at position j; allowed and support hold cipherWord.length() masks
+    int candidateLetters(std::string_view cipherWord, std::string_view currTranslation, const unsigned int* allowed, unsigned int* support) const;
       // We prevent a WordList object from being copied or assigned.
     WordList(const WordList&) = delete;
     WordList& operator=(const WordList&) = delete;
@@ -46,6 +82,7 @@ public:
     bool pushMapping(std::string ciphertext, std::string plaintext);
     bool popMapping();
     std::string getTranslation(const std::string& ciphertext) const;
+    bool canPushMapping(std::string_view ciphertext, std::string_view plaintext) const; // would pushMapping succeed? Changes nothing.
       // We prevent an Translator object from being copied or assigned.
     Translator(const Translator&) = delete;
     Translator& operator=(const Translator&) = delete;
@@ -55,13 +92,78 @@ private:
 
 class DecrypterImpl;
 
+enum WordOrder // how crack picks the ciphertext word to branch on next; both find the same decryptions
+{
+    MOST_UNTRANSLATED, // the word with the most untranslated letters (the default)
+    FEWEST_CANDIDATES  // the word with the fewest dictionary candidates left, ties going to the one covering more unbound letters
+};
+
+const int CANDIDATE_HISTOGRAM_BUCKETS = 8; // findCandidates result sizes 0, 1, 2-3, 4-7, ..., 32-63 and 64 or more
+
+struct CrackStats
+{
+    long m_nodesExpanded = 0;        // search nodes that looked up candidates for a word
+    double m_wallMs = 0;             // wall time of the crack
+      // Set m_detailed before cracking to also fill in everything below it. It is off by default, since timing the
+      // phases reads the clock a few times per node; left off, the search only tests one pointer per counter.
+    bool m_detailed = false;
+    long m_pushes = 0;               // candidates pushed onto the mapping, including pushes replaying a path
+    long m_pops = 0;
+    long m_rejectedConflicting = 0;  // candidates contradicting a letter already translated (the old containsBadWord)
+    long m_rejectedByDomains = 0;    // candidates using a translation propagation had ruled out
+    long m_prunedNotInList = 0;      // pushes completing a word missing from the word list
+    long m_prunedNoCandidates = 0;   // pushes leaving a partly translated word without candidates
+    long m_prunedByPropagation = 0;  // pushes after which propagation emptied a letter's domain
+    long m_prunedRepeated = 0;       // pushes reaching a mapping already searched or output
+    long m_candidateHistogram[CANDIDATE_HISTOGRAM_BUCKETS] = {}; // findCandidates calls by result size
+    int m_maxDepth = 0;              // most candidates pushed at once
+    double m_prepareMs = 0;          // tokenizing the ciphertext and setting up the search
+    double m_candidatesMs = 0;       // in findCandidates
+    double m_checkMs = 0;            // pushing candidates and checking them; summed over threads in a parallel crack
+    double m_sortMs = 0;             // sorting the decryptions
+};
+
+struct CrackLimits // when a bounded crack stops early; the defaults never stop it
+{
+    long m_maxResults = 0; // most decryptions to find; 0 means no limit. Finding this many stops the search, incomplete
+    long m_maxNodes = 0;   // most search nodes to expand; 0 means no limit
+    std::chrono::steady_clock::time_point m_deadline = std::chrono::steady_clock::time_point::max();
+      // called with each decryption as soon as it is found, never from two threads at once; returning false stops the search
+    std::function<bool(const std::string& decryption)> m_onDecryption;
+};
+
+struct RankedDecryption
+{
+    std::string m_decryption;
+    double m_logProbability; // sum of WordList::logFrequency over the message's words
+};
+
+struct BatchReport
+{
+    std::vector<double> m_latencyMs; // time to crack each message, in input order
+    double m_totalMs;                // wall time of the whole batch
+    double m_messagesPerSecond;
+};
+
 class Decrypter
 {
 public:
     Decrypter();
     ~Decrypter();
     bool load(std::string filename);
-    std::vector<std::string> crack(const std::string& ciphertext);
+      // crack and crackBatch only read the loaded word list, so once load has returned they may be called from several threads at once;
+      // each decryption is returned once, even if the word list repeats words
+    std::vector<std::string> crack(const std::string& ciphertext, CrackStats* stats = nullptr) const;
+      // crack, stopping as soon as a limit is reached and returning the decryptions found so far, sorted;
+      // sets *complete to whether the whole search was done, so the decryptions returned are all there are
+    std::vector<std::string> crack(const std::string& ciphertext, const CrackLimits& limits, bool* complete, CrackStats* stats = nullptr) const;
+      // best-first crack on a single thread: the decryptions most likely under the word list's frequency column come
+      // first, so limits.m_maxResults = k gives the top k; with no limits it finds the same decryptions as crack
+    std::vector<RankedDecryption> crackRanked(const std::string& ciphertext, const CrackLimits& limits, bool* complete, CrackStats* stats = nullptr) const;
+      // cracks every message, one per thread at a time, and returns their decryptions in input order
+    std::vector<std::vector<std::string>> crackBatch(const std::vector<std::string>& ciphertexts, BatchReport* report = nullptr) const;
+    void setThreadCount(int threadCount); // threads crack and crackBatch use; 1 (the default) searches serially
+    void setWordOrder(WordOrder order);
       // We prevent a Decrypter object from being copied or assigned.
     Decrypter(const Decrypter&) = delete;
     Decrypter& operator=(const Decrypter&) = delete;